@@ -116,7 +116,7 @@ for (my $j = 0; $j < $rangesTotal; ++$j) {
 		my $x = defined($w) ? scalar(@$w) : 0;
 		next if ($x == 0);
 		print "|$n| has $x $ppLabel lines\n";
-		next if ($ppLabel eq "dmrg");
+		next if ($ppLabel eq "dmrg" || $ppLabel eq "energiesLike");
 
 		if ($ppLabel eq "observe") {
 			$cmd .= runObserve($n, $w, $sOptions);
@@ -80,12 +80,13 @@ for (my $j = 0; $j < $rangesTotal; ++$j) {
 	my @ciAnnotations = Ci::getCiAnnotations("inputs/input$n.inp",$n);
 	my $totalAnnotations = scalar(@ciAnnotations);
 
-	my @postProcessLabels = qw(getTimeObservablesInSitu getEnergyAncilla CollectBrakets metts observe);
+	my @postProcessLabels = qw(getTimeObservablesInSitu getEnergyAncilla CollectBrakets metts observe energiesLike);
 	my %actions = (getTimeObservablesInSitu => \&checkTimeInSituObs,
 	               getEnergyAncilla => \&checkEnergyAncillaInSitu,
 	               CollectBrakets => \&checkCollectBrakets,
 	               metts => \&checkMetts,
-	               observe => \&checkObserve);
+	               observe => \&checkObserve,
+	               energiesLike => \&checkEnergiesLike);
 	for (my $i = 0; $i < $totalAnnotations; ++$i) {
 		my ($ppLabel, $w) = Ci::readAnnotationFromIndex(\@ciAnnotations, $i);
 		my $x = defined($w) ? scalar(@$w) : 0;
@@ -472,6 +473,30 @@ sub checkMetts
 	}
 }
 
+#Compares the energies of test n with those of test m of the same run,
+#for tests that change only how something is computed or stored
+#Annotation is #ci energiesLike m tolerance
+#Test n fails if an energy differs from that of m by more than tolerance
+sub checkEnergiesLike
+{
+	my ($n, $what, $workdir, $golddir) = @_;
+	my ($m, $tolerance) = split(/ +/, $what->[0]);
+	defined($tolerance) or $tolerance = 0;
+	my %newValues;
+	my %refValues;
+	procCout(\%newValues, $n, $workdir);
+	procCout(\%refValues, $m, $workdir);
+	my $maxEdiff = maxEnergyDiff($newValues{"energies"}, $refValues{"energies"});
+	my $mode = "FAILED";
+	if ($maxEdiff =~ /^([^ ]+) \[out of/) {
+		$mode = "OK" if ($1 <= $tolerance);
+	}
+
+	print "|$n|: MaxEnergyDiff against $m = $maxEdiff, tolerance $tolerance, $mode\n";
+	return if ($mode eq "OK");
+	print "$0: ATTENTION TEST $n energies differ from those of $m by more than $tolerance\n";
+}
+
 sub checkObserve
 {
 	my ($n, $ignored, $workdir, $golddir) = @_;
@@ -85,6 +85,7 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 #include "HamiltonianSymmetrySu2.h"
 #include "ProgressIndicator.h"
 #include "Qn.h"
+#include <algorithm>
 
 namespace Dmrg {
 // A class to represent in a light way a Dmrg basis (used only to implement symmetries).
@@ -110,7 +111,8 @@ public:
 	typedef typename HamiltonianSymmetrySu2Type::PairType PairType;
 	typedef typename QnType::VectorQnType VectorQnType;
 
-	enum {SAVE_ALL, SAVE_PARTIAL};
+	// SAVE_ALL_SINGLE: as SAVE_ALL, with operator values in single precision
+	enum {SAVE_ALL, SAVE_PARTIAL, SAVE_ALL_SINGLE};
 
 	//! Constructor, s=name of this basis
 	Basis(const PsimagLite::String& s)
@@ -164,11 +166,11 @@ public:
 	                  const ThisType& basis2,
 	                  const QnType* pseudoQn = 0)
 	{
-		const QnType zeroQn(0, VectorSizeType(), PairType(0, 0), 0);
-
 		block_.clear();
 		utils::blockUnion(block_,basis1.block_,basis2.block_);
 		VectorQnType qns;
+		electronsOfLeft_.clear();
+		electronsOfRight_.clear();
 
 		if (useSu2Symmetry_) {
 			std::cout<<"Basis: SU(2) Symmetry is in use\n";
@@ -176,45 +178,55 @@ public:
 			symmSu2_.setToProduct(basis1.symmSu2_,
 			                      basis2.symmSu2_,
 			                      pseudoQn,
-			                      basis1.electrons_,
-			                      basis2.electrons_,
+			                      basis1.electronsVector(),
+			                      basis2.electronsVector(),
 			                      electrons_,
 			                      qns);
 		} else {
 			SizeType ns = basis2.size();
 			SizeType ne = basis1.size();
 
-			unsigned long int check = ns*ne;
+			// product taken in unsigned long, so that it cannot wrap around
+			// before being checked against the width of SizeType
+			unsigned long int check = static_cast<unsigned long int>(ns)*ne;
 			unsigned int shift = 8*sizeof(SizeType)-1;
 			unsigned long int max = 1;
 			max <<= shift;
 			if (check >= max) {
 				PsimagLite::String msg("Basis::setToProduct: Basis too large. ");
 				msg += "Current= "+ ttos(check) + " max " + ttos(max) + " ";
+#ifdef USE_LONG
+				msg += "\n";
+#else
 				msg += "Please recompile with -DUSE_LONG\n";
+#endif
 				throw PsimagLite::RuntimeError(msg);
 			}
 
-			SizeType npe = basis2.partition_.size();
-			if (npe > 0) --npe;
-			SizeType nps = basis1.partition_.size();
-			if (nps > 0) --nps;
+			// order quantum numbers of combined basis:
+			productPermutationAndPartitionAndQns(basis1, basis2);
+
+			if (pseudoQn) {
+				// superblock: electrons and signs are computed on demand
+				// from those of the two factors, see electrons(i)
+				electronsOfLeft_ = basis1.electronsVector();
+				electronsOfRight_ = basis2.electronsVector();
+				electrons_.clear();
+				signsOld_.clear();
+				return;
+			}
 
-			qns.resize(basis1.size() * basis2.size(), zeroQn);
-			electrons_.resize(qns.size());
+			const VectorSizeType& electrons1 = basis1.electronsVector();
+			const VectorSizeType& electrons2 = basis2.electronsVector();
+			electrons_.resize(ns*ne);
 			SizeType counter = 0;
-			for (SizeType pe = 0; pe < npe; ++pe) {
-				for (SizeType i = basis2.partition_[pe]; i < basis2.partition_[pe + 1]; ++i) {
-					for (SizeType ps = 0; ps < nps; ++ps) {
-						for (SizeType j = basis1.partition_[ps];
-						     j < basis1.partition_[ps + 1];
-						     ++j) {
-							qns[counter] = QnType(basis2.qns_[pe], basis1.qns_[ps]);
-							electrons_[counter++] = basis1.electrons_[j] + basis2.electrons_[i];
-						}
-					}
-				}
-			}
+			for (SizeType i = 0; i < ns; ++i)
+				for (SizeType j = 0; j < ne; ++j)
+					electrons_[counter++] = electrons1[j] + electrons2[i];
+
+			reorder();
+			electronsToSigns(electrons_);
+			return;
 		}
 
 		bool notSuper = (basis1.block().size() == 1 || basis2.block().size() == 1);
@@ -346,6 +358,14 @@ public:
 	//! returns the number of electrons for state i of this basis
 	SizeType electrons(SizeType i) const
 	{
+		if (electronsOfLeft_.size() > 0) {
+			assert(i < permutationVector_.size());
+			SizeType ind = permutationVector_[i];
+			SizeType ne = electronsOfLeft_.size();
+			assert(ind/ne < electronsOfRight_.size());
+			return electronsOfLeft_[ind % ne] + electronsOfRight_[ind/ne];
+		}
+
 		assert(i < electrons_.size() || electrons_.size() == 0);
 		return (i < electrons_.size()) ? electrons_[i] : 0;
 	}
@@ -382,15 +402,31 @@ public:
 	}
 
 	//! Returns the vector of electrons for this basis
-	const VectorSizeType& electronsVector() const { return electrons_; }
+	//! The superblock does not store it, and computes a copy
+	VectorSizeType electronsVector() const
+	{
+		if (electronsOfLeft_.size() == 0) return electrons_;
 
-	const VectorBoolType& oldSigns() const { return signsOld_; }
+		VectorSizeType electrons;
+		VectorBoolType signs;
+		computeElectrons(electrons, signs);
+		return electrons;
+	}
+
+	VectorBoolType oldSigns() const
+	{
+		if (electronsOfLeft_.size() == 0) return signsOld_;
+
+		VectorSizeType electrons;
+		VectorBoolType signs;
+		computeElectrons(electrons, signs);
+		return signs;
+	}
 
 	//! Returns the fermionic sign for state i
 	int fermionicSign(SizeType i,int f) const
 	{
-		assert(i < electrons_.size());
-		return (electrons_[i] & 1) ? f : 1;
+		return (electrons(i) & 1) ? f : 1;
 	}
 
 	//! Returns the (j,m) for state i of this basis
@@ -475,7 +511,13 @@ public:
 		io.write(useSu2Symmetry_, label + "useSu2Symmetry");
 		io.write(block_, label + "BLOCK");
 
-		if (!minimizeWrite) {
+		if (!minimizeWrite && electronsOfLeft_.size() > 0) {
+			VectorSizeType electrons;
+			VectorBoolType signs;
+			computeElectrons(electrons, signs);
+			io.write(electrons, label + "ELECTRONS");
+			io.write(signs, label + "SignsOld");
+		} else if (!minimizeWrite) {
 			io.write(electrons_, label + "ELECTRONS");
 			io.write(signsOld_, label + "SignsOld");
 		}
@@ -500,6 +542,25 @@ public:
 		write(io, prefix + "/" + name_, mode, minimizeWrite);
 	}
 
+	//! exchanges contents with other without copying; this is how
+	//! a basis is handed over when the source is no longer needed
+	void swap(Basis& other)
+	{
+		qns_.swap(other.qns_);
+		electrons_.swap(other.electrons_);
+		signsOld_.swap(other.signsOld_);
+		electronsOfLeft_.swap(other.electronsOfLeft_);
+		electronsOfRight_.swap(other.electronsOfRight_);
+		partition_.swap(other.partition_);
+		permutationVector_.swap(other.permutationVector_);
+		permInverse_.swap(other.permInverse_);
+		std::swap(symmLocal_, other.symmLocal_);
+		std::swap(symmSu2_, other.symmSu2_);
+		block_.swap(other.block_);
+		std::swap(dmrgTransformed_, other.dmrgTransformed_);
+		name_.swap(other.name_);
+	}
+
 	//! The operator<< is a friend
 	friend std::ostream& operator<<(std::ostream& os,
 	                                const Basis<SparseMatrixType>& x)
@@ -509,7 +570,7 @@ public:
 		os<<"quantumNumbers\n";
 		os<<x.quantumNumbers_;
 		os<<"electrons\n";
-		os<<x.electrons_;
+		os<<x.electronsVector();
 		os<<"partition\n";
 		os<<x.partition_;
 		os<<"permutation\n";
@@ -533,6 +594,8 @@ protected:
 		if (useSu2Symmetry_) symmSu2_.set(basisData);
 
 		SizeType n = basisData.size();
+		electronsOfLeft_.clear();
+		electronsOfRight_.clear();
 		electrons_.resize(n);
 		for (SizeType i = 0; i < n; ++i)
 			electrons_[i] = basisData[i].electrons;
@@ -558,6 +621,8 @@ private:
 		prefix += "/";
 		io.read(useSu2Symmetry_, prefix + "useSu2Symmetry");
 		io.read(block_, prefix + "BLOCK");
+		electronsOfLeft_.clear();
+		electronsOfRight_.clear();
 
 		if (!minimizeRead) {
 			io.read(electrons_, prefix + "ELECTRONS");
@@ -624,6 +689,9 @@ private:
 
 	void truncate(VectorQnType& qns, const VectorSizeType& removedIndices)
 	{
+		if (electronsOfLeft_.size() > 0) computeElectrons(electrons_, signsOld_);
+		electronsOfLeft_.clear();
+		electronsOfRight_.clear();
 		utils::truncateVector(qns, removedIndices);
 		utils::truncateVector(electrons_,removedIndices);
 		if (useSu2Symmetry_) symmSu2_.truncate(removedIndices, electrons_);
@@ -654,6 +722,93 @@ private:
 		}
 	}
 
+	// Same result as findPermutationAndPartitionAndQns on the per-state
+	// quantum numbers of the product basis, state i*ne + j, where
+	// ne = basis1.size(), but computed per pair of partitions:
+	// the Qn of each pair is built once, its partition found with a map
+	// keyed by Qn::pack, and the sizes of the partitions prefix-summed.
+	// Partitions are numbered by first appearance, as in Qn::notReallySort,
+	// and the permutation lists the states of each partition in increasing
+	// order
+	void productPermutationAndPartitionAndQns(const ThisType& basis1,
+	                                          const ThisType& basis2)
+	{
+		typedef typename PsimagLite::Map<VectorSizeType, SizeType>::Type MapType;
+
+		SizeType npe = basis2.partition_.size();
+		if (npe > 0) --npe;
+		SizeType nps = basis1.partition_.size();
+		if (nps > 0) --nps;
+		SizeType ne = basis1.size();
+
+		MapType sectorOfKey;
+		VectorSizeType key;
+		VectorSizeType sectorOfPair(npe*nps, 0);
+		VectorSizeType count;
+		qns_.clear();
+		for (SizeType pe = 0; pe < npe; ++pe) {
+			SizeType rows = basis2.partition_[pe + 1] - basis2.partition_[pe];
+			for (SizeType ps = 0; ps < nps; ++ps) {
+				SizeType cols = basis1.partition_[ps + 1] - basis1.partition_[ps];
+				if (rows*cols == 0) continue;
+				QnType qn(basis2.qns_[pe], basis1.qns_[ps]);
+				qn.pack(key);
+				typename MapType::iterator it = sectorOfKey.find(key);
+				SizeType x = 0;
+				if (it == sectorOfKey.end()) {
+					x = qns_.size();
+					sectorOfKey[key] = x;
+					qns_.push_back(qn);
+					count.push_back(0);
+				} else {
+					x = it->second;
+				}
+
+				sectorOfPair[ps + pe*nps] = x;
+				count[x] += rows*cols;
+			}
+		}
+
+		SizeType numberOfPatches = count.size();
+		partition_.resize(numberOfPatches + 1);
+		partition_[0] = 0;
+		for (SizeType ipatch = 0; ipatch < numberOfPatches; ++ipatch)
+			partition_[ipatch + 1] = partition_[ipatch] + count[ipatch];
+
+		permutationVector_.resize(partition_[numberOfPatches]);
+		std::fill(count.begin(), count.end(), 0);
+		for (SizeType pe = 0; pe < npe; ++pe) {
+			for (SizeType i = basis2.partition_[pe]; i < basis2.partition_[pe + 1]; ++i) {
+				for (SizeType ps = 0; ps < nps; ++ps) {
+					SizeType x = sectorOfPair[ps + pe*nps];
+					SizeType start = basis1.partition_[ps];
+					SizeType end = basis1.partition_[ps + 1];
+					SizeType outIndex = partition_[x] + count[x];
+					for (SizeType j = start; j < end; ++j)
+						permutationVector_[outIndex++] = j + i*ne;
+					count[x] += end - start;
+				}
+			}
+		}
+
+		permInverse_.resize(permutationVector_.size());
+		for (SizeType i = 0; i < permInverse_.size(); ++i)
+			permInverse_[permutationVector_[i]] = i;
+	}
+
+	// electrons and signs of a superblock, from those of its two factors
+	void computeElectrons(VectorSizeType& electrons, VectorBoolType& signs) const
+	{
+		SizeType n = permutationVector_.size();
+		electrons.resize(n);
+		for (SizeType i = 0; i < n; ++i)
+			electrons[i] = this->electrons(i);
+
+		signs.resize(n);
+		for (SizeType i = 0; i < n; ++i)
+			signs[i] = (electrons[i] & 1);
+	}
+
 	void electronsToSigns(const VectorSizeType& electrons)
 	{
 		SizeType n = electrons.size();
@@ -705,8 +860,11 @@ these numbers are
 		systems of correlated electrons.)
 		*/
 	VectorQnType qns_;
+	// empty for a superblock, see electrons(i)
 	VectorSizeType electrons_;
 	VectorBoolType signsOld_;
+	VectorSizeType electronsOfLeft_;
+	VectorSizeType electronsOfRight_;
 
 	/* PSIDOC BasisPartition
 		What remains to be done is to find a partition of the basis which
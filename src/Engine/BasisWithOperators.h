@@ -79,6 +79,8 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 
 #include "ApplyFactors.h"
 #include "Basis.h"
+#include "Checksum.h"
+#include "SinglePrecisionStorage.h"
 
 namespace Dmrg {
 
@@ -147,6 +149,7 @@ public:
 	{
 		const PsimagLite::String prefix = ss + "/";
 		io.read(operatorsPerSite_, prefix + "OperatorPerSite");
+		if (!isObserveCode) verifyChecksum(io, ss);
 	}
 
 	template<typename IoInputter>
@@ -158,6 +161,7 @@ public:
 		BasisType::read(io, prefix); // parent loads
 		operators_.read(io, prefix);
 		io.read(operatorsPerSite_, prefix + "/OperatorPerSite");
+		verifyChecksum(io, prefix);
 	}
 
 	// set this basis to the outer product of
@@ -180,54 +184,22 @@ public:
 		// reorder the basis
 		parent.setToProduct(basis2, basis3);
 
-		typename PsimagLite::Vector<RealType>::Type fermionicSigns;
 		SizeType x = basis2.numberOfOperators()+basis3.numberOfOperators();
 
 		if (this->useSu2Symmetry()) setMomentumOfOperators(basis2);
 		operators_.setToProduct(basis2,basis3,x,this);
 		ApplyFactors<FactorsType> apply(this->getFactors(),this->useSu2Symmetry());
-		int savedSign = 0;
-
-		for (SizeType i=0;i<this->numberOfOperators();i++) {
-			if (i<basis2.numberOfOperators()) {
-				if (!this->useSu2Symmetry()) {
-					const OperatorType& myOp =  basis2.getOperatorByIndex(i);
-					if (savedSign != myOp.fermionSign) {
-						utils::fillFermionicSigns(fermionicSigns,
-						                          basis2.electronsVector(),
-						                          myOp.fermionSign);
-						savedSign = myOp.fermionSign;
-					}
-					operators_.externalProduct(i,
-					                           myOp,
-					                           basis3.size(),
-					                           fermionicSigns,
-					                           true,
-					                           apply);
-				} else {
+
+		if (!this->useSu2Symmetry()) {
+			externalProductReordered(basis2, basis3);
+		} else {
+			for (SizeType i=0;i<this->numberOfOperators();i++) {
+				if (i<basis2.numberOfOperators()) {
 					operators_.externalProductReduced(i,
 					                                  basis2,
 					                                  basis3,
 					                                  true,
 					                                  basis2.getReducedOperatorByIndex(i));
-				}
-			} else {
-				if (!this->useSu2Symmetry()) {
-					const OperatorType& myOp = basis3.
-					        getOperatorByIndex(i - basis2.numberOfOperators());
-
-					if (savedSign != myOp.fermionSign) {
-						utils::fillFermionicSigns(fermionicSigns,
-						                          basis2.electronsVector(),
-						                          myOp.fermionSign);
-						savedSign = myOp.fermionSign;
-					}
-					operators_.externalProduct(i,
-					                           myOp,
-					                           basis2.size(),
-					                           fermionicSigns,
-					                           false,
-					                           apply);
 				} else {
 					operators_.externalProductReduced(i,
 					                                  basis2,
@@ -248,7 +220,10 @@ public:
 		                                          basis2.reducedHamiltonian(),
 		                                          basis3.reducedHamiltonian());
 		//! re-order operators and hamiltonian
-		operators_.reorder(BaseType::permutationVector());
+		if (!this->useSu2Symmetry())
+			operators_.reorderHamiltonian(BaseType::permutationVector());
+		else
+			operators_.reorder(BaseType::permutationVector());
 
 		SizeType offset1 = basis2.operatorsPerSite_.size();
 		operatorsPerSite_.resize(offset1+basis3.operatorsPerSite_.size());
@@ -264,12 +239,15 @@ public:
 	RealType truncateBasis(const BlockDiagonalMatrixType& ftransform,
 	                       const typename PsimagLite::Vector<RealType>::Type& eigs,
 	                       const typename PsimagLite::Vector<SizeType>::Type& removedIndices,
-	                       const PairSizeSizeType& startEnd)
+	                       const PairSizeSizeType& startEnd,
+	                       RealType dropTolerance = 0)
 	{
 		BasisType &parent = *this;
 		RealType error = parent.truncateBasis(eigs,removedIndices);
 
-		operators_.changeBasis(ftransform,this,startEnd);
+		// never drop more than what the truncation itself discards
+		if (dropTolerance > error) dropTolerance = error;
+		operators_.changeBasis(ftransform,this,startEnd,dropTolerance);
 
 		return error;
 	}
@@ -309,7 +287,10 @@ public:
 		operators_.setHamiltonian(h);
 		operators_.setOperators(ops);
 		//! re-order operators and hamiltonian
-		operators_.reorder(BaseType::permutationVector());
+		if (!this->useSu2Symmetry())
+			operators_.reorderHamiltonian(BaseType::permutationVector());
+		else
+			operators_.reorder(BaseType::permutationVector());
 
 		operatorsPerSite_.clear();
 		for (SizeType i=0;i<block.size();i++)
@@ -367,10 +348,37 @@ public:
 	           PsimagLite::IsOutputLike<SomeIoType>::True, int>::Type = 0) const
 	{
 		BasisType::write(io, s, mode, false); // parent saves
+		bool single = (option == BasisType::SAVE_ALL_SINGLE &&
+		               !BasisType::useSu2Symmetry());
 		if (option == BasisType::SAVE_ALL)
 			operators_.write(io, s, mode);
+		else if (option == BasisType::SAVE_ALL_SINGLE)
+			operators_.writeSinglePrecision(io, s);
 
 		io.write(operatorsPerSite_, s + "/OperatorPerSite", mode);
+		if (option != BasisType::SAVE_PARTIAL)
+			io.write(checksum(single), s + "/Checksum", mode);
+	}
+
+	// of what is saved with SAVE_ALL; with single, of what is read back
+	// after saving with SAVE_ALL_SINGLE
+	SizeType checksum(bool single = false) const
+	{
+		Checksum sum;
+		sum.add(this->block());
+		sum.add(this->permutationVector());
+		sum.add(this->electronsVector());
+		addMatrix(sum, hamiltonian(), single);
+		sum.add(operatorsPerSite_);
+		if (BasisType::useSu2Symmetry()) return sum.value();
+
+		for (SizeType i = 0; i < numberOfOperators(); ++i) {
+			const OperatorType& op = getOperatorByIndex(i);
+			addMatrix(sum, op.data, single);
+			sum.add(op.fermionSign);
+		}
+
+		return sum.value();
 	}
 
 	template<typename SomeOutputType>
@@ -384,8 +392,87 @@ public:
 		write(io, prefix + "/" + this->name(), mode, option);
 	}
 
+	//! exchanges contents with other without copying; each object keeps
+	//! its own Operators-to-Basis link
+	void swap(ThisType& other)
+	{
+		BasisType::swap(other);
+		operators_.swap(other.operators_);
+		operatorsPerSite_.swap(other.operatorsPerSite_);
+	}
+
+	//! copies what write() saves with SAVE_PARTIAL, which is all but the
+	//! operators and the Hamiltonian
+	void copyForPartialWrite(const ThisType& other)
+	{
+		BasisType& parent = *this;
+		parent = other;
+		operatorsPerSite_ = other.operatorsPerSite_;
+	}
+
 private:
 
+	static void addMatrix(Checksum& sum, const SparseMatrixType& m, bool single)
+	{
+		if (single)
+			SinglePrecisionStorage<SparseMatrixType>::addTo(sum, m);
+		else
+			sum.add(m);
+	}
+
+	template<typename IoInputter>
+	void verifyChecksum(IoInputter& io, const PsimagLite::String& ss) const
+	{
+		SizeType stored = 0;
+		try {
+			io.read(stored, ss + "/Checksum");
+		} catch (...) {
+			return; // saved before checksums existed, or without SAVE_ALL
+		}
+
+		if (stored == checksum()) return;
+		err("BasisWithOperators: checksum mismatch reading " + ss + "\n");
+	}
+
+	// operators of basis2 become A x I, those of basis3 become I x A;
+	// the fermionic sign for the latter comes from the states of basis2
+	void externalProductReordered(const ThisType& basis2,
+	                              const ThisType& basis3)
+	{
+		typedef typename OperatorsType::VectorOperatorPtrType VectorOperatorPtrType;
+		typedef typename OperatorsType::VectorBoolType VectorBoolType;
+		typedef typename PsimagLite::Vector<RealType>::Type VectorRealType;
+
+		SizeType n2 = basis2.numberOfOperators();
+		SizeType n = n2 + basis3.numberOfOperators();
+		VectorOperatorPtrType sources(n, 0);
+		VectorIntegerType sizes(n, 0);
+		VectorBoolType options(n, true);
+		for (SizeType i = 0; i < n; ++i) {
+			if (i < n2) {
+				sources[i] = &basis2.getOperatorByIndex(i);
+				sizes[i] = basis3.size();
+			} else {
+				sources[i] = &basis3.getOperatorByIndex(i - n2);
+				sizes[i] = basis2.size();
+				options[i] = false;
+			}
+		}
+
+		VectorRealType signsBoson;
+		VectorRealType signsFermion;
+		utils::fillFermionicSigns(signsBoson, basis2.electronsVector(), 1);
+		utils::fillFermionicSigns(signsFermion, basis2.electronsVector(), -1);
+
+		operators_.externalProductReordered(sources,
+		                                    sizes,
+		                                    options,
+		                                    signsBoson,
+		                                    signsFermion,
+		                                    BaseType::permutationVector(),
+		                                    BaseType::permutationInverse());
+	}
+
 	void setMomentumOfOperators(const ThisType& basis)
 	{
 		PsimagLite::Vector<SizeType>::Type momentum;
@@ -79,6 +79,7 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 #ifndef BLOCK_DIAGONAL_MATRIX_H
 #define BLOCK_DIAGONAL_MATRIX_H
 #include <vector>
+#include <algorithm>
 #include <iostream>
 #include "Matrix.h" // in PsimagLite
 #include "ProgramGlobals.h"
@@ -88,6 +89,7 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 #include "PsimagLite.h"
 #include "EnforcePhase.h"
 #include "Io/IoSelector.h"
+#include "Checksum.h"
 
 namespace Dmrg {
 
@@ -103,7 +105,8 @@ class BlockDiagonalMatrix {
 
 public:
 
-	enum SaveEnum {SAVE_ALL, SAVE_PARTIAL};
+	// transformations are always saved in full precision
+	enum SaveEnum {SAVE_ALL, SAVE_PARTIAL, SAVE_ALL_SINGLE};
 
 	typedef MatrixInBlockTemplate BuildingBlockType;
 	typedef typename BuildingBlockType::value_type ComplexOrRealType;
@@ -119,10 +122,13 @@ public:
 
 	BlockDiagonalMatrix(IoInType& io, PsimagLite::String label)
 	{
-		io.read(isSquare_, label + "/isSquare_");
-		io.read(offsetsRows_, label + "/offsetRows_");
-		io.read(offsetsCols_, label + "/offsetCols_");
-		io.read(data_, label + "/data_");
+		load(io, label);
+	}
+
+	// same as BasisWithOperators, so that it can be kept in an OutOfCoreStack
+	BlockDiagonalMatrix(IoInType& io, PsimagLite::String label, bool)
+	{
+		load(io, label);
 	}
 
 	template<typename SomeBasisType>
@@ -148,6 +154,18 @@ public:
 		io.write(offsetsRows_, label1 + "/offsetRows_");
 		io.write(offsetsCols_, label1 + "/offsetCols_");
 		io.write(data_, label1 + "/data_");
+		io.write(checksum(), label1 + "/checksum_");
+	}
+
+	template<typename SomeIoType>
+	void write(SomeIoType& io,
+	           const PsimagLite::String& label,
+	           typename SomeIoType::Serializer::WriteMode,
+	           SizeType,
+	           typename PsimagLite::EnableIf<
+	           PsimagLite::IsOutputLike<SomeIoType>::True, int>::Type = 0) const
+	{
+		write(label, io);
 	}
 
 	void setTo(ComplexOrRealType value)
@@ -303,6 +321,14 @@ public:
 		ioSerializer.read(offsetsRows_, label + "/offsetsRows");
 		ioSerializer.read(offsetsCols_, label + "/offsetsCols");
 		ioSerializer.read(data_, label + "/data");
+		SizeType stored = 0;
+		try {
+			ioSerializer.read(stored, label + "/checksum");
+		} catch (...) {
+			return; // saved before checksums existed
+		}
+
+		verifyChecksum(stored, label);
 	}
 
 	void write(PsimagLite::String label, PsimagLite::IoSerializer& ioSerializer) const
@@ -312,6 +338,25 @@ public:
 		ioSerializer.write(label + "/offsetsRows", offsetsRows_);
 		ioSerializer.write(label + "/offsetsCols", offsetsCols_);
 		ioSerializer.write(label + "/data", data_);
+		ioSerializer.write(label + "/checksum", checksum());
+	}
+
+	SizeType checksum() const
+	{
+		Checksum sum;
+		sum.add(isSquare_);
+		sum.add(offsetsRows_);
+		sum.add(offsetsCols_);
+		sum.add(data_);
+		return sum.value();
+	}
+
+	void swap(BlockDiagonalMatrix& other)
+	{
+		std::swap(isSquare_, other.isSquare_);
+		offsetsRows_.swap(other.offsetsRows_);
+		offsetsCols_.swap(other.offsetsCols_);
+		data_.swap(other.data_);
 	}
 
 	friend std::ostream& operator<<(std::ostream& os, const BlockDiagonalMatrix& m)
@@ -355,6 +400,28 @@ public:
 
 private:
 
+	void load(IoInType& io, PsimagLite::String label)
+	{
+		io.read(isSquare_, label + "/isSquare_");
+		io.read(offsetsRows_, label + "/offsetRows_");
+		io.read(offsetsCols_, label + "/offsetCols_");
+		io.read(data_, label + "/data_");
+		SizeType stored = 0;
+		try {
+			io.read(stored, label + "/checksum_");
+		} catch (...) {
+			return; // saved before checksums existed
+		}
+
+		verifyChecksum(stored, label);
+	}
+
+	void verifyChecksum(SizeType stored, PsimagLite::String label) const
+	{
+		if (stored == checksum()) return;
+		err("BlockDiagonalMatrix: checksum mismatch reading " + label + "\n");
+	}
+
 	void computeRemap(VectorIntType& remap,
 	                  const VectorSizeType& removedIndices2) const
 	{
@@ -3,6 +3,8 @@
 #include "CrsMatrix.h"
 #include "BlockDiagonalMatrix.h"
 #include "LAPACK.h"
+#include "Concurrency.h"
+#include "Parallelizer.h"
 
 namespace Dmrg {
 
@@ -16,6 +18,90 @@ class BlockOffDiagMatrix {
 	typedef PsimagLite::Vector<SizeType>::Type VectorSizeType;
 	typedef std::pair<SizeType, SizeType> PairType;
 	typedef PsimagLite::Vector<VectorSizeType>::Type VectorVectorSizeType;
+	typedef typename PsimagLite::Vector<PairType>::Type VectorPairType;
+	typedef typename PsimagLite::Vector<MatrixBlockType>::Type VectorMatrixBlockType;
+
+	// data_(i, j) <-- transposeConjugate(f(i)) * data_(i, j) * f(j)
+	// for each nonzero patch pair, one pair per task;
+	// the intermediate product lives in a per-thread temporary
+	class ParallelTransform {
+
+	public:
+
+		ParallelTransform(PsimagLite::Matrix<MatrixBlockType*>& data,
+		                  const BlockDiagonalMatrixType& f,
+		                  const VectorPairType& patches,
+		                  SizeType nthreads)
+		    : data_(data),
+		      f_(f),
+		      patches_(patches),
+		      tmp_(nthreads)
+		{}
+
+		SizeType tasks() const { return patches_.size(); }
+
+		void doTask(SizeType taskNumber, SizeType threadNum)
+		{
+			assert(taskNumber < patches_.size());
+			assert(threadNum < tmp_.size());
+			SizeType ipatch = patches_[taskNumber].first;
+			SizeType jpatch = patches_[taskNumber].second;
+			MatrixBlockType* mptr = data_(ipatch, jpatch);
+			assert(mptr);
+			MatrixBlockType& m = *mptr;
+			const MatrixBlockType& mRight = f_(jpatch);
+			const MatrixBlockType& mLeft = f_(ipatch);
+
+			if (mLeft.rows() == 0 || mRight.rows() == 0) {
+				m.clear();
+				return;
+			}
+
+			assert(m.cols() == mRight.rows());
+			assert(m.rows() == mLeft.rows());
+
+			MatrixBlockType& tmp = tmp_[threadNum];
+			tmp.clear();
+			tmp.resize(m.rows(), mRight.cols());
+			// tmp = data_[ii] * mRight;
+			psimag::BLAS::GEMM('N',
+			                   'N',
+			                   m.rows(),
+			                   mRight.cols(),
+			                   m.cols(),
+			                   1.0,
+			                   &(m(0,0)),
+			                   m.rows(),
+			                   &(mRight(0,0)),
+			                   mRight.rows(),
+			                   0.0,
+			                   &(tmp(0,0)),
+			                   tmp.rows());
+			// data_[ii] = transposeConjugate(mLeft) * tmp;
+			m.clear();
+			m.resize(mLeft.cols(), mRight.cols());
+			psimag::BLAS::GEMM('C',
+			                   'N',
+			                   mLeft.cols(),
+			                   tmp.cols(),
+			                   tmp.rows(),
+			                   1.0,
+			                   &(mLeft(0,0)),
+			                   mLeft.rows(),
+			                   &(tmp(0,0)),
+			                   tmp.rows(),
+			                   0.0,
+			                   &(m(0,0)),
+			                   m.rows());
+		}
+
+	private:
+
+		PsimagLite::Matrix<MatrixBlockType*>& data_;
+		const BlockDiagonalMatrixType& f_;
+		const VectorPairType& patches_;
+		VectorMatrixBlockType tmp_;
+	};
 
 public:
 
@@ -39,9 +125,8 @@ public:
 
 		VectorSizeType indexToPart(rows_, 0);
 		fillIndexToPart(indexToPart, partitions);
-		PsimagLite::Matrix<SizeType> icount(n, n);
-		icount.setTo(0);
 
+		// single pass: a patch is allocated when its first nonzero is seen
 		for (SizeType row = 0; row < rows_; ++row) {
 			SizeType kStart = sparse.getRowPtr(row);
 			SizeType kEnd = sparse.getRowPtr(row + 1);
@@ -49,28 +134,15 @@ public:
 			for (SizeType k = kStart; k < kEnd; ++k) {
 				SizeType col = sparse.getCol(k);
 				SizeType jpatch = indexToPart[col];
-				icount(ipatch, jpatch)++;
-			}
-		}
-
-		for (SizeType ipatch = 0; ipatch < n; ++ipatch) {
-			SizeType rows = partitions[ipatch + 1] - partitions[ipatch];
-			for (SizeType jpatch = 0; jpatch < n; ++jpatch) {
-				SizeType cols = partitions[jpatch + 1] - partitions[jpatch];
-				if (icount(ipatch, jpatch) == 0) continue;
-				data_(ipatch, jpatch) = new MatrixBlockType(rows, cols);
-			}
-		}
+				MatrixBlockType* mptr = data_(ipatch, jpatch);
+				if (mptr == 0) {
+					SizeType rows = partitions[ipatch + 1] - partitions[ipatch];
+					SizeType cols = partitions[jpatch + 1] - partitions[jpatch];
+					mptr = data_(ipatch, jpatch) = new MatrixBlockType(rows, cols);
+				}
 
-		for (SizeType row = 0; row < rows_; ++row) {
-			SizeType kStart = sparse.getRowPtr(row);
-			SizeType kEnd = sparse.getRowPtr(row + 1);
-			SizeType ipatch = indexToPart[row];
-			for (SizeType k = kStart; k < kEnd; ++k) {
-				SizeType col = sparse.getCol(k);
-				SizeType jpatch = indexToPart[col];
-				MatrixBlockType& m = *(data_(ipatch, jpatch));
-				m(row - partitions[ipatch], col - partitions[jpatch]) = sparse.getValue(k);
+				(*mptr)(row - partitions[ipatch], col - partitions[jpatch]) =
+				        sparse.getValue(k);
 			}
 		}
 	}
@@ -141,68 +213,41 @@ public:
 		sparse.checkValidity();
 	}
 
-	void transform(const BlockDiagonalMatrixType& f)
+	// threads is the number of threads for this transform; 1 when called from
+	// a section that is already threaded
+	void transform(const BlockDiagonalMatrixType& f, SizeType threads = 1)
 	{
 		if (offsetCols_.size() != 0)
 			err("BlockOffDiagMatrix::transform() only for square matrix\n");
 
 		assert(offsetRows_.size() > 0);
 		SizeType n = offsetRows_.size() - 1;
+		VectorPairType patches;
+		VectorSizeType weights;
 		for (SizeType ipatch = 0; ipatch < n; ++ipatch) {
 			for (SizeType jpatch = 0; jpatch < n; ++jpatch) {
-				MatrixBlockType* mptr = data_(ipatch, jpatch);
+				const MatrixBlockType* mptr = data_(ipatch, jpatch);
 				if (mptr == 0) continue;
-				MatrixBlockType& m = *mptr;
-				const MatrixBlockType& mRight = f(jpatch);
-				const MatrixBlockType& mLeft = f(ipatch);
-
-				if (mLeft.rows() == 0 || mRight.rows() == 0) {
-					m.clear();
-					continue;
-				}
-
-				assert(m.cols() == mRight.rows());
-				assert(m.rows() == mLeft.rows());
-
-				MatrixBlockType tmp(m.rows(), mRight.cols());
-				// tmp = data_[ii] * mRight;
-				psimag::BLAS::GEMM('N',
-				                   'N',
-				                   m.rows(),
-				                   mRight.cols(),
-				                   m.cols(),
-				                   1.0,
-				                   &(m(0,0)),
-				                   m.rows(),
-				                   &(mRight(0,0)),
-				                   mRight.rows(),
-				                   0.0,
-				                   &(tmp(0,0)),
-				                   tmp.rows());
-				// data_[ii] = transposeConjugate(mLeft) * tmp;
-				m.clear();
-				m.resize(mLeft.cols(), mRight.cols());
-				psimag::BLAS::GEMM('C',
-				                   'N',
-				                   mLeft.cols(),
-				                   tmp.cols(),
-				                   tmp.rows(),
-				                   1.0,
-				                   &(mLeft(0,0)),
-				                   mLeft.rows(),
-				                   &(tmp(0,0)),
-				                   tmp.rows(),
-				                   0.0,
-				                   &(m(0,0)),
-				                   m.rows());
+				patches.push_back(PairType(ipatch, jpatch));
+				weights.push_back(1 + mptr->rows()*mptr->cols());
 			}
+		}
 
-			offsetRows_ = f.offsetsCols();
-			n = offsetRows_.size();
-			assert(n > 0);
-			--n;
-			cols_ = rows_ = offsetRows_[n];
+		if (patches.size() > 0) {
+			if (threads > patches.size()) threads = patches.size();
+			if (threads == 0) threads = 1;
+			typedef PsimagLite::Parallelizer<ParallelTransform> ParallelizerType;
+			PsimagLite::CodeSectionParams codeSectionParams(threads);
+			ParallelizerType threaded(codeSectionParams);
+			ParallelTransform helper(data_, f, patches, threads);
+			threaded.loopCreate(helper, weights);
 		}
+
+		offsetRows_ = f.offsetsCols();
+		n = offsetRows_.size();
+		assert(n > 0);
+		--n;
+		cols_ = rows_ = offsetRows_[n];
 	}
 
 	SizeType rows() const
@@ -32,11 +32,11 @@ public:
 		transposeConjugate(oldTtranspose_, oldT_);
 	}
 
-	void operator()(SparseMatrixType &v) const
+	void operator()(SparseMatrixType &v, SizeType threads = 1) const
 	{
 		if (!ProgramGlobals::oldChangeOfBasis) {
 			BlockOffDiagMatrixType vBlocked(v, transform_.offsetsRows());
-			vBlocked.transform(transform_);
+			vBlocked.transform(transform_, threads);
 			vBlocked.toSparse(v);
 			return;
 		}
@@ -48,11 +48,12 @@ public:
 	}
 
 	static void changeBasis(SparseMatrixType &v,
-	                        const BlockDiagonalMatrixType& ftransform1)
+	                        const BlockDiagonalMatrixType& ftransform1,
+	                        SizeType threads = 1)
 	{
 		if (!ProgramGlobals::oldChangeOfBasis) {
 			BlockOffDiagMatrixType vBlocked(v, ftransform1.offsetsRows());
-			vBlocked.transform(ftransform1);
+			vBlocked.transform(ftransform1, threads);
 			vBlocked.toSparse(v);
 			return;
 		}
@@ -67,6 +68,13 @@ public:
 		multiply(v,ftransformT,tmp);
 	}
 
+	void swap(ChangeOfBasis& other)
+	{
+		transform_.swap(other.transform_);
+		oldT_.swap(other.oldT_);
+		oldTtranspose_.swap(other.oldTtranspose_);
+	}
+
 private:
 
 	BlockDiagonalMatrixType transform_;
@@ -83,6 +83,8 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 
 #include "Stack.h"
 #include "DiskStackNg.h"
+#include "OutOfCoreStack.h"
+#include "Map.h"
 #include "ProgressIndicator.h"
 #include "ProgramGlobals.h"
 #include "Io/IoSelector.h"
@@ -104,12 +106,46 @@ public:
 	typedef typename ModelType::InputValidatorType InputValidatorType;
 	typedef typename OperatorsType::OperatorType OperatorType;
 	typedef typename OperatorType::StorageType SparseMatrixType;
-	typedef typename PsimagLite::Stack<BasisWithOperatorsType>::Type MemoryStackType;
+	typedef OutOfCoreStack<BasisWithOperatorsType> MemoryStackType;
 	typedef typename BasisWithOperatorsType::QnType QnType;
 	typedef typename QnType::VectorQnType VectorQnType;
 	typedef DiskStack<BasisWithOperatorsType>  DiskStackType;
 	typedef PsimagLite::Vector<PsimagLite::String>::Type VectorStringType;
 	typedef PsimagLite::Vector<SizeType>::Type VectorSizeType;
+	typedef typename MemoryStackType::Snapshot StackSnapshotType;
+
+	struct StacksSnapshot {
+		StackSnapshotType system;
+		StackSnapshotType environment;
+	};
+
+	// where a stack entry, by generation id, has been saved
+	struct SavedEntry {
+
+		SavedEntry() : tag(0), record(0) {}
+
+		SavedEntry(PsimagLite::String f, SizeType t, SizeType r)
+		    : file(f), tag(t), record(r)
+		{}
+
+		PsimagLite::String file;
+		SizeType tag;
+		SizeType record;
+	};
+
+	typedef typename PsimagLite::Map<SizeType, SavedEntry>::Type MapSavedEntryType;
+
+	// written counts the entries of the last snapshot that were written,
+	// the others being references
+	struct SavedEntries {
+
+		SavedEntries() : systemWritten(0), environmentWritten(0) {}
+
+		MapSavedEntryType system;
+		MapSavedEntryType environment;
+		SizeType systemWritten;
+		SizeType environmentWritten;
+	};
 
 	const PsimagLite::String SYSTEM_STACK_STRING;
 	const PsimagLite::String ENVIRON_STACK_STRING;
@@ -123,9 +159,16 @@ public:
 	    parameters_(parameters),
 	    isObserveCode_(isObserveCode),
 	    isRestart_(parameters_.options.find("restart")!=PsimagLite::String::npos),
+	    systemStack_(parameters_.filename,
+	                 "system",
+	                 residentStackEntries(parameters_),
+	                 isObserveCode_),
+	    envStack_(parameters_.filename,
+	              "environ",
+	              residentStackEntries(parameters_),
+	              isObserveCode_),
 	    progress_("Checkpoint"),
-	    energyFromFile_(0.0),
-	    dummyBwo_("dummy")
+	    energyFromFile_(0.0)
 	{
 		if (parameters_.autoRestart) isRestart_ = true;
 
@@ -178,23 +221,47 @@ public:
 		loadStacksMemoryToDisk();
 	}
 
-	void checkpointStacks(PsimagLite::String filename) const
+	// The sweep may go on, changing the stacks, until releaseSnapshot
+	void snapshotStacks(StacksSnapshot& snapshot) const
 	{
-		// taken from dtor
-		PsimagLite::OstringStream msg;
-		msg<<"Writing sys. and env. stacks to disk...";
-		progress_.printline(msg, std::cout);
+		systemStack_.takeSnapshot(snapshot.system);
+		envStack_.takeSnapshot(snapshot.environment);
+	}
 
+	// Writes the stacks of snapshot to filename, which will be renamed
+	// finalName, from any thread. Entries found in saved are written as
+	// references to the files that have them; on return saved holds
+	// the entries of this snapshot only, so it describes finalName.
+	static void writeSnapshot(PsimagLite::String filename,
+	                          PsimagLite::String finalName,
+	                          SizeType tag,
+	                          const StacksSnapshot& snapshot,
+	                          SavedEntries& saved)
+	{
 		const bool needsToRead = false;
+		const bool isObserveCode = false;
+
+		DiskStackType systemDisk(filename, needsToRead, "system", isObserveCode);
+		saved.systemWritten = writeSnapshot(systemDisk,
+		                                    finalName,
+		                                    tag,
+		                                    snapshot.system,
+		                                    saved.system);
+		systemDisk.close();
+
+		DiskStackType environDisk(filename, needsToRead, "environ", isObserveCode);
+		saved.environmentWritten = writeSnapshot(environDisk,
+		                                         finalName,
+		                                         tag,
+		                                         snapshot.environment,
+		                                         saved.environment);
+		environDisk.close();
+	}
 
-		MemoryStackType systemStackCopy = systemStack_;
-		DiskStackType systemDisk(filename, needsToRead, "system", isObserveCode_);
-
-		loadStack(systemDisk, systemStackCopy);
-
-		MemoryStackType envStackCopy = envStack_;
-		DiskStackType environDisk(filename, needsToRead, "environ", isObserveCode_);
-		loadStack(environDisk, envStackCopy);
+	void releaseSnapshot(StacksSnapshot& snapshot) const
+	{
+		systemStack_.releaseSnapshot(snapshot.system);
+		envStack_.releaseSnapshot(snapshot.environment);
 	}
 
 	// Not related to stacks
@@ -225,10 +292,10 @@ public:
 		typename IoType::In ioTmp(parameters_.checkpoint.filename);
 
 		BasisWithOperatorsType pS1(ioTmp, "CHKPOINTSYSTEM", isObserveCode);
+		pS.swap(pS1);
 
-		pS = pS1;
 		BasisWithOperatorsType pE1(ioTmp, "CHKPOINTENVIRON", isObserveCode);
-		pE = pE1;
+		pE.swap(pE1);
 		PsimagLite::IoSelector::In io(parameters_.checkpoint.filename);
 		psi.read(io, prefix);
 	}
@@ -245,10 +312,14 @@ public:
 		else systemStack_.push(pSorE);
 	}
 
-	const BasisWithOperatorsType& shrink(SizeType what,const TargetingType& target)
+	// shrinks the stack what and sets dest to its new top, which stays
+	// in the stack; dest is the only copy made
+	void shrink(SizeType what,
+	            const TargetingType& target,
+	            BasisWithOperatorsType& dest)
 	{
-		if (what==ProgramGlobals::ENVIRON) return shrink(envStack_,target);
-		else return shrink(systemStack_,target);
+		if (what==ProgramGlobals::ENVIRON) shrink(envStack_, target, dest);
+		else shrink(systemStack_, target, dest);
 	}
 
 	bool isRestart() const { return isRestart_; }
@@ -268,8 +339,7 @@ public:
 	static void loadStack(StackType1& stackInMemory,StackType2& stackInDisk)
 	{
 		while (stackInDisk.size()>0) {
-			BasisWithOperatorsType b = stackInDisk.top();
-			stackInMemory.push(b);
+			stackInMemory.push(stackInDisk.top());
 			stackInDisk.pop();
 		}
 	}
@@ -388,17 +458,54 @@ private:
 		}
 	}
 
+	// returns the number of entries written, the others being references
+	static SizeType writeSnapshot(DiskStackType& disk,
+	                              PsimagLite::String finalName,
+	                              SizeType tag,
+	                              const StackSnapshotType& snapshot,
+	                              MapSavedEntryType& saved)
+	{
+		disk.setTag(tag);
+		MapSavedEntryType current;
+		SizeType written = 0;
+		for (SizeType i = 0; i < snapshot.entries.size(); ++i) {
+			SizeType id = snapshot.entries[i].id;
+			typename MapSavedEntryType::const_iterator it = saved.find(id);
+			if (it != saved.end()) {
+				disk.pushReference(it->second.file, it->second.tag, it->second.record);
+				current[id] = it->second;
+				continue;
+			}
+
+			MemoryStackType::pushSnapshotEntryInto(disk, snapshot, i);
+			current[id] = SavedEntry(finalName, tag, disk.recordOfTop());
+			++written;
+		}
+
+		saved.swap(current);
+		return written;
+	}
+
 	//! shrink  (we don't really shrink, we just undo the growth)
-	const BasisWithOperatorsType& shrink(MemoryStackType& thisStack,
-	                                     const TargetingType& target)
+	void shrink(MemoryStackType& thisStack,
+	            const TargetingType& target,
+	            BasisWithOperatorsType& dest)
 	{
 		assert(thisStack.size() > 0);
 		thisStack.pop();
 		assert(thisStack.size() > 0);
-		dummyBwo_ =  thisStack.top();
+		dest = thisStack.top();
 		// only updates the extreme sites:
-		target.updateOnSiteForCorners(dummyBwo_);
-		return dummyBwo_;
+		target.updateOnSiteForCorners(dest);
+	}
+
+	// with stacksInDisk only the top entries of each stack stay in memory;
+	// two, so that the next one to be popped can be read while the
+	// current top is in use
+	static SizeType residentStackEntries(const ParametersType& parameters)
+	{
+		bool inDisk = (parameters.options.find("stacksInDisk") != PsimagLite::String::npos);
+		return (inDisk) ? 2 : 0;
 	}
 
 	void loadStacksDiskToMemory()
@@ -412,11 +519,23 @@ private:
 		                      "environ",
 		                      isObserveCode_);
 		PsimagLite::OstringStream msg;
-		msg<<"Loading sys. and env. stacks from disk...";
+		msg<<"Indexing sys. and env. stacks on disk; entries are read when needed";
 		progress_.printline(msg,std::cout);
 
-		loadStack(systemStack_, systemDisk);
-		loadStack(envStack_, envDisk);
+		pushFromDisk(systemStack_, systemDisk);
+		pushFromDisk(envStack_, envDisk);
+	}
+
+	// same order as loadStack, but only the locations are pushed
+	static void pushFromDisk(MemoryStackType& stackInMemory,
+	                         const DiskStackType& stackInDisk)
+	{
+		for (SizeType i = 0; i < stackInDisk.size(); ++i) {
+			PsimagLite::String file;
+			PsimagLite::String group;
+			stackInDisk.locationOf(stackInDisk.size() - 1 - i, file, group);
+			stackInMemory.pushFromFile(file, group);
+		}
 	}
 
 	void loadStacksMemoryToDisk()
@@ -434,7 +553,9 @@ private:
 		msg<<"Writing sys. and env. stacks to disk...";
 		progress_.printline(msg,std::cout);
 		loadStack(systemDisk, systemStack_);
+		systemDisk.close();
 		loadStack(envDisk, envStack_);
+		envDisk.close();
 	}
 
 	//! Move elsewhere
@@ -457,7 +578,6 @@ private:
 	MemoryStackType envStack_;
 	PsimagLite::ProgressIndicator progress_;
 	RealType energyFromFile_;
-	BasisWithOperatorsType dummyBwo_;
 }; // class Checkpoint
 } // namespace Dmrg
 
@@ -0,0 +1,148 @@
+/*
+Copyright (c) 2009-2019, UT-Battelle, LLC
+All rights reserved
+
+[DMRG++, Version 5.]
+[by G.A., Oak Ridge National Laboratory]
+
+UT Battelle Open Source Software License 11242008
+
+OPEN SOURCE LICENSE
+
+Subject to the conditions of this License, each
+contributor to this software hereby grants, free of
+charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), a
+perpetual, worldwide, non-exclusive, no-charge,
+royalty-free, irrevocable copyright license to use, copy,
+modify, merge, publish, distribute, and/or sublicense
+copies of the Software.
+
+1. Redistributions of Software must retain the above
+copyright and license notices, this list of conditions,
+and the following disclaimer.  Changes or modifications
+to, or derivative works of, the Software should be noted
+with comments and the contributor and organization's
+name.
+
+2. Neither the names of UT-Battelle, LLC or the
+Department of Energy nor the names of the Software
+contributors may be used to endorse or promote products
+derived from this software without specific prior written
+permission of UT-Battelle.
+
+3. The software and the end-user documentation included
+with the redistribution, with or without modification,
+must include the following acknowledgment:
+
+"This product includes software produced by UT-Battelle,
+LLC under Contract No. DE-AC05-00OR22725  with the
+Department of Energy."
+
+*********************************************************
+DISCLAIMER
+
+THE SOFTWARE IS SUPPLIED BY THE COPYRIGHT HOLDERS AND
+CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER, CONTRIBUTORS, UNITED STATES GOVERNMENT,
+OR THE UNITED STATES DEPARTMENT OF ENERGY BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+DAMAGE.
+
+NEITHER THE UNITED STATES GOVERNMENT, NOR THE UNITED
+STATES DEPARTMENT OF ENERGY, NOR THE COPYRIGHT OWNER, NOR
+ANY OF THEIR EMPLOYEES, REPRESENTS THAT THE USE OF ANY
+INFORMATION, DATA, APPARATUS, PRODUCT, OR PROCESS
+DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
+
+*********************************************************
+*/
+
+/** \ingroup DMRG */
+/*@{*/
+
+/*! \file Checksum.h
+ *
+ *  FNV-1a checksum of in-memory data, to check that what is read
+ *  back from a file is what was written
+ */
+
+#ifndef DMRG_CHECKSUM_H
+#define DMRG_CHECKSUM_H
+#include "Vector.h"
+#include "Matrix.h"
+#include "CrsMatrix.h"
+
+namespace Dmrg {
+
+class Checksum {
+
+public:
+
+	Checksum() : value_(2166136261ul) {}
+
+	// scalars only: the bytes of x are hashed as they are
+	template<typename T>
+	void add(const T& x)
+	{
+		const unsigned char* p = reinterpret_cast<const unsigned char*>(&x);
+		for (SizeType i = 0; i < sizeof(T); ++i) {
+			value_ ^= p[i];
+			value_ = (value_*16777619ul) & 0xfffffffful;
+		}
+	}
+
+	template<typename T>
+	void add(const std::vector<T>& v)
+	{
+		add(v.size());
+		for (SizeType i = 0; i < v.size(); ++i)
+			add(v[i]);
+	}
+
+	template<typename T>
+	void add(const PsimagLite::Matrix<T>& m)
+	{
+		add(m.rows());
+		add(m.cols());
+		for (SizeType j = 0; j < m.cols(); ++j)
+			for (SizeType i = 0; i < m.rows(); ++i)
+				add(m(i, j));
+	}
+
+	template<typename T>
+	void add(const PsimagLite::CrsMatrix<T>& m)
+	{
+		SizeType rows = m.rows();
+		add(rows);
+		add(m.cols());
+		for (SizeType i = 0; i <= rows; ++i)
+			add(m.getRowPtr(i));
+
+		SizeType nonZeros = m.nonZeros();
+		for (SizeType k = 0; k < nonZeros; ++k) {
+			add(m.getCol(k));
+			add(m.getValue(k));
+		}
+	}
+
+	SizeType value() const { return value_; }
+
+private:
+
+	unsigned long int value_;
+}; // class Checksum
+} // namespace Dmrg
+
+/*@}*/
+#endif
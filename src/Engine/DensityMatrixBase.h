@@ -101,13 +101,15 @@ public:
 
 	struct Params {
 
-		Params(bool u, ProgramGlobals::DirectionEnum d, bool de)
-		    : useSvd(u), direction(d), debug(de)
+		Params(bool u, ProgramGlobals::DirectionEnum d, bool de, SizeType pk = 0)
+		    : useSvd(u), direction(d), debug(de), partialKept(pk)
 		{}
 
 		bool useSvd;
 		ProgramGlobals::DirectionEnum direction;
 		bool debug;
+		// if non-zero, only the leading eigenpairs needed to keep these states
+		SizeType partialKept;
 	};
 
 	typedef typename BlockDiagonalMatrixType::BuildingBlockType BuildingBlockType;
@@ -80,6 +80,8 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 #include "Concurrency.h"
 #include "Parallelizer.h"
 #include "DiagBlockDiagMatrix.h"
+#include "RandomizedEigs.h"
+#include "EnforcePhase.h"
 
 namespace Dmrg {
 
@@ -98,6 +100,7 @@ class DensityMatrixLocal : public DensityMatrixBase<TargetingType> {
 	typedef PsimagLite::ProgressIndicator ProgressIndicatorType;
 	typedef typename PsimagLite::Real<DensityMatrixElementType>::Type RealType;
 	typedef typename DensityMatrixBase<TargetingType>::Params ParamsType;
+	typedef typename PsimagLite::Vector<RealType>::Type VectorRealType;
 
 	enum {EXPAND_SYSTEM = ProgramGlobals::EXPAND_SYSTEM };
 
@@ -105,6 +108,86 @@ public:
 
 	typedef typename BaseType::BlockDiagonalMatrixType BlockDiagonalMatrixType;
 	typedef typename BlockDiagonalMatrixType::BuildingBlockType BuildingBlockType;
+	typedef RandomizedEigs<BuildingBlockType> RandomizedEigsType;
+	typedef typename RandomizedEigsType::VectorBoolType VectorBoolType;
+	typedef typename PsimagLite::Vector<BuildingBlockType>::Type VectorBuildingBlockType;
+
+private:
+
+	class ParallelPartialDiag {
+
+	public:
+
+		ParallelPartialDiag(BlockDiagonalMatrixType& data,
+		                    VectorRealType& eigs,
+		                    VectorRealType& residuals,
+		                    VectorBuildingBlockType& u,
+		                    SizeType kept,
+		                    char jobz,
+		                    const VectorBoolType* redo)
+		    : data_(data),
+		      eigs_(eigs),
+		      residuals_(residuals),
+		      u_(u),
+		      kept_(kept),
+		      jobz_(jobz),
+		      redo_(redo)
+		{}
+
+		SizeType tasks() const { return data_.blocks(); }
+
+		void doTask(SizeType m, SizeType)
+		{
+			if (redo_) {
+				if ((*redo_)[m]) diagFull(m);
+				return;
+			}
+
+			SizeType offset = data_.offsetsRows(m);
+			SizeType n = data_.offsetsRows(m + 1) - offset;
+			SizeType k = RandomizedEigsType::rank(n, data_.rows(), kept_);
+			if (k == 0) {
+				diagFull(m);
+				return;
+			}
+
+			RandomizedEigsType randomized(data_(m), false);
+			VectorRealType eigsTmp;
+			RealType residual = 0;
+			if (!randomized(u_[m], eigsTmp, residual, k)) {
+				diagFull(m);
+				return;
+			}
+
+			for (SizeType j = 0; j < n; ++j)
+				eigs_[j + offset] = eigsTmp[j];
+			residuals_[m] = residual;
+		}
+
+	private:
+
+		void diagFull(SizeType m)
+		{
+			SizeType offset = data_.offsetsRows(m);
+			SizeType n = data_.offsetsRows(m + 1) - offset;
+			VectorRealType eigsTmp;
+			data_.diagAndEnforcePhase(m, eigsTmp, jobz_);
+			for (SizeType j = 0; j < n; ++j)
+				eigs_[j + offset] = eigsTmp[j];
+			residuals_[m] = -1;
+		}
+
+		BlockDiagonalMatrixType& data_;
+		VectorRealType& eigs_;
+		VectorRealType& residuals_;
+		VectorBuildingBlockType& u_;
+		SizeType kept_;
+		char jobz_;
+		const VectorBoolType* redo_;
+	};
+
+public:
+
 	typedef ParallelDensityMatrix<BlockDiagonalMatrixType,
 	BasisWithOperatorsType,
 	TargetVectorType> ParallelDensityMatrixType;
@@ -117,7 +200,8 @@ public:
 	      progress_("DensityMatrixLocal"),
 	      data_((p.direction == ProgramGlobals::EXPAND_SYSTEM) ? lrs.left() : lrs.right()),
 	      direction_(p.direction),
-	      debug_(p.debug)
+	      debug_(p.debug),
+	      partialKept_(p.partialKept)
 	{
 		{
 			PsimagLite::OstringStream msg;
@@ -133,39 +217,40 @@ public:
 		        (p.direction == ProgramGlobals::EXPAND_SYSTEM) ? lrs.right() :
 		                                                         lrs.left();
 
-		//loop over all partitions:
-		for (SizeType m=0;m<pBasis.partition()-1;m++) {
-			// size of this partition
-			SizeType bs = pBasis.partition(m+1)-pBasis.partition(m);
-
-			// density matrix block for this partition:
-			BuildingBlockType matrixBlock(bs,bs);
-
-			// weight of the ground state:
-			RealType w = target.gsWeight();
-
-			// if we are to target the ground state do it now:
-			if (target.includeGroundStage()) initPartition(matrixBlock,
-			                                               pBasis,
-			                                               m,
-			                                               target.gs(),
-			                                               pBasisSummed,
-			                                               lrs.super(),
-			                                               p.direction,
-			                                               w);
-
-			// target all other states if any:
-			for (SizeType ix = 0; ix < target.size(); ++ix) {
-				RealType wnorm = target.normSquared(ix);
-				if (fabs(wnorm) < 1e-6) continue;
-				RealType w = target.weight(ix)/wnorm;
-				initPartition(matrixBlock,pBasis,m,target(ix),
-				              pBasisSummed,lrs.super(),p.direction,w);
-			}
+		// density matrix blocks, one per partition:
+		SizeType total = pBasis.partition() - 1;
+		typename ParallelDensityMatrixType::VectorBuildingBlockType matrixBlocks(total);
+		for (SizeType m = 0; m < total; ++m) {
+			SizeType bs = pBasis.partition(m + 1) - pBasis.partition(m);
+			matrixBlocks[m].resize(bs, bs);
+			matrixBlocks[m].setTo(0.0);
+		}
 
-			// set this matrix block into data_
-			data_.setBlock(m,pBasis.partition(m),matrixBlock);
+		// weight of the ground state:
+		RealType w = target.gsWeight();
+
+		// if we are to target the ground state do it now:
+		if (target.includeGroundStage()) initPartitions(matrixBlocks,
+		                                                pBasis,
+		                                                target.gs(),
+		                                                pBasisSummed,
+		                                                lrs.super(),
+		                                                p.direction,
+		                                                w);
+
+		// target all other states if any:
+		for (SizeType ix = 0; ix < target.size(); ++ix) {
+			RealType wnorm = target.normSquared(ix);
+			if (fabs(wnorm) < 1e-6) continue;
+			RealType w = target.weight(ix)/wnorm;
+			initPartitions(matrixBlocks,pBasis,target(ix),
+			               pBasisSummed,lrs.super(),p.direction,w);
 		}
+
+		// set the matrix blocks into data_
+		for (SizeType m = 0; m < total; ++m)
+			data_.setBlock(m,pBasis.partition(m),matrixBlocks[m]);
+
 		{
 			PsimagLite::OstringStream msg;
 			msg<<"Done with init partition";
@@ -181,7 +266,10 @@ public:
 
 	void diag(typename PsimagLite::Vector<RealType>::Type& eigs,char jobz)
 	{
-		DiagBlockDiagMatrix<BlockDiagonalMatrixType>::diagonalise(data_,eigs,jobz);
+		if (partialKept_ == 0 || partialKept_ >= data_.rows())
+			DiagBlockDiagMatrix<BlockDiagonalMatrixType>::diagonalise(data_,eigs,jobz);
+		else
+			diagPartial(eigs, jobz);
 	}
 
 	friend std::ostream& operator<<(std::ostream& os,
@@ -198,32 +286,68 @@ public:
 
 private:
 
-	void initPartition(BuildingBlockType& matrixBlock,
-	                   BasisWithOperatorsType const &pBasis,
-	                   SizeType m,
-	                   const TargetVectorType& v,
-	                   BasisWithOperatorsType const &pBasisSummed,
-	                   BasisType const &pSE,
-	                   ProgramGlobals::DirectionEnum direction,
-	                   RealType weight)
+	void initPartitions(typename ParallelDensityMatrixType::VectorBuildingBlockType& matrixBlocks,
+	                    BasisWithOperatorsType const &pBasis,
+	                    const TargetVectorType& v,
+	                    BasisWithOperatorsType const &pBasisSummed,
+	                    BasisType const &pSE,
+	                    ProgramGlobals::DirectionEnum direction,
+	                    RealType weight)
 	{
 		ParallelDensityMatrixType helperDm(v,
 		                                   pBasis,
 		                                   pBasisSummed,
 		                                   pSE,
 		                                   direction,
-		                                   m,
 		                                   weight,
-		                                   matrixBlock);
+		                                   matrixBlocks);
 		ParallelizerType threadedDm(ConcurrencyType::codeSectionParams);
 		threadedDm.loopCreate(helperDm);
 
 	}
 
+	// Only the leading eigenpairs of the large blocks, with
+	// a full diagonalization of the blocks where they might not suffice
+	void diagPartial(VectorRealType& eigs, char jobz)
+	{
+		typedef PsimagLite::Parallelizer<ParallelPartialDiag> ParallelizerPartialType;
+
+		SizeType blocks = data_.blocks();
+		eigs.resize(data_.rows());
+		VectorRealType residuals(blocks, -1);
+		VectorBuildingBlockType u(blocks);
+
+		ParallelPartialDiag helper(data_, eigs, residuals, u, partialKept_, jobz, 0);
+		ParallelizerPartialType threaded(ConcurrencyType::codeSectionParams);
+		threaded.loopCreate(helper);
+
+		VectorBoolType redo;
+		SizeType redone = RandomizedEigsType::borderline(redo, eigs, residuals, partialKept_);
+		if (redone > 0) {
+			ParallelPartialDiag helper2(data_, eigs, residuals, u, partialKept_, jobz, &redo);
+			ParallelizerPartialType threaded2(ConcurrencyType::codeSectionParams);
+			threaded2.loopCreate(helper2);
+		}
+
+		SizeType partial = 0;
+		for (SizeType m = 0; m < blocks; ++m) {
+			if (residuals[m] < 0) continue;
+			EnforcePhase<DensityMatrixElementType>::enforcePhase(u[m]);
+			data_.setBlock(m, data_.offsetsRows(m), u[m]);
+			++partial;
+		}
+
+		PsimagLite::OstringStream msg;
+		msg<<"truncationRandomized: "<<partial<<" of "<<blocks<<" blocks done partially, ";
+		msg<<redone<<" borderline blocks redone fully";
+		progress_.printline(msg,std::cout);
+	}
+
 	ProgressIndicatorType progress_;
 	BlockDiagonalMatrixType data_;
 	ProgramGlobals::DirectionEnum direction_;
 	bool debug_;
+	SizeType partialKept_;
 }; // class DensityMatrixLocal
 
 } // namespace Dmrg
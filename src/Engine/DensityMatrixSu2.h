@@ -85,6 +85,9 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 #include "DensityMatrixBase.h"
 #include "ProgramGlobals.h"
 #include "DiagBlockDiagMatrix.h"
+#include "Concurrency.h"
+#include "Parallelizer.h"
+#include "BLAS.h"
 
 namespace Dmrg {
 template<typename TargetingType>
@@ -100,10 +103,104 @@ class DensityMatrixSu2 : public DensityMatrixBase<TargetingType> {
 	typedef typename BasisType::FactorsType FactorsType;
 	typedef typename PsimagLite::Real<ComplexOrRealType>::Type RealType;
 	typedef typename DensityMatrixBase<TargetingType>::Params ParamsType;
+	typedef typename PsimagLite::Vector<ComplexOrRealType>::Type VectorType;
+	typedef typename PsimagLite::Vector<VectorType>::Type VectorVectorType;
+	typedef typename PsimagLite::Vector<RealType>::Type VectorRealType;
 
 public:
 
 	typedef typename BlockDiagonalMatrixType::BuildingBlockType BuildingBlockType;
+	typedef typename PsimagLite::Vector<BuildingBlockType>::Type VectorBuildingBlockType;
+
+private:
+
+	/* Adds weight*psi*psi^dagger to each block, where
+	   psi(alpha, beta) = w(alpha + beta*ns) (or w(beta + alpha*ns) when expanding
+	   the environ) and w is a target vector already contracted with the factors.
+	   Columns beta that are zero for this block are skipped. Tasks are blocks */
+	class ParallelBlocks {
+
+	public:
+
+		ParallelBlocks(VectorBuildingBlockType& blocks,
+		               const VectorVectorType& w,
+		               const VectorRealType& weights,
+		               const BasisType& pBasis,
+		               SizeType summedSize,
+		               SizeType ns,
+		               bool expandSys)
+		    : blocks_(blocks),
+		      w_(w),
+		      weights_(weights),
+		      pBasis_(pBasis),
+		      summedSize_(summedSize),
+		      ns_(ns),
+		      expandSys_(expandSys)
+		{}
+
+		SizeType tasks() const { return blocks_.size(); }
+
+		void doTask(SizeType m, SizeType)
+		{
+			SizeType start = pBasis_.partition(m);
+			SizeType bs = pBasis_.partition(m + 1) - start;
+			if (bs == 0) return;
+
+			BuildingBlockType& block = blocks_[m];
+			typename PsimagLite::Vector<SizeType>::Type nonZeroColumns;
+			for (SizeType t = 0; t < w_.size(); ++t) {
+				const VectorType& w = w_[t];
+				nonZeroColumns.clear();
+				for (SizeType beta = 0; beta < summedSize_; ++beta) {
+					for (SizeType a = 0; a < bs; ++a) {
+						if (w[index(a + start, beta)] == static_cast<RealType>(0.0))
+							continue;
+						nonZeroColumns.push_back(beta);
+						break;
+					}
+				}
+
+				SizeType cols = nonZeroColumns.size();
+				if (cols == 0) continue;
+
+				BuildingBlockType psi(bs, cols);
+				for (SizeType c = 0; c < cols; ++c)
+					for (SizeType a = 0; a < bs; ++a)
+						psi(a, c) = w[index(a + start, nonZeroColumns[c])];
+
+				psimag::BLAS::GEMM('N',
+				                   'C',
+				                   bs,
+				                   bs,
+				                   cols,
+				                   weights_[t],
+				                   &(psi(0,0)),
+				                   bs,
+				                   &(psi(0,0)),
+				                   bs,
+				                   1.0,
+				                   &(block(0,0)),
+				                   bs);
+			}
+		}
+
+	private:
+
+		SizeType index(SizeType alpha, SizeType beta) const
+		{
+			return (expandSys_) ? alpha + beta*ns_ : beta + alpha*ns_;
+		}
+
+		VectorBuildingBlockType& blocks_;
+		const VectorVectorType& w_;
+		const VectorRealType& weights_;
+		const BasisType& pBasis_;
+		SizeType summedSize_;
+		SizeType ns_;
+		bool expandSys_;
+	};
+
+public:
 
 	DensityMatrixSu2(const TargetingType& target,
 	                 const LeftRightSuperType& lrs,
@@ -115,13 +212,14 @@ public:
 	      debug_(p.debug)
 	{
 		check();
-		BuildingBlockType matrixBlock;
 
 		const BasisWithOperatorsType& pBasisSummed =
 		        (p.direction == ProgramGlobals::EXPAND_SYSTEM) ? lrs.right() :
 		                                                         lrs.left();
 
-		for (SizeType m = 0; m < pBasis_.partition() - 1; ++m) {
+		SizeType total = pBasis_.partition() - 1;
+		VectorBuildingBlockType matrixBlocks(total);
+		for (SizeType m = 0; m < total; ++m) {
 			// Definition: Given partition p with (j m)
 			// findMaximalPartition(p) returns the partition p' (with j,j)
 
@@ -132,21 +230,45 @@ public:
 			}
 
 			SizeType bs = pBasis_.partition(m+1)-pBasis_.partition(m);
+			matrixBlocks[m].resize(bs, bs);
+			matrixBlocks[m].setTo(0.0);
+		}
 
-			matrixBlock.resize(bs, bs, static_cast<ComplexOrRealType>(0.0));
-
-			for (SizeType i=pBasis_.partition(m);i<pBasis_.partition(m+1);i++) {
-				for (SizeType j=pBasis_.partition(m);j<pBasis_.partition(m+1);j++) {
-
-					matrixBlock(i-pBasis_.partition(m),j-pBasis_.partition(m))=
-					        densityMatrixAux(i,j,target,pBasisSummed,lrs.super(),p.direction);
-
-				}
-			}
+		// contract each target with the factors, once
+		// The g.s. is a separate argument because it's
+		// usually a vector of RealType, whereas
+		// the other targets might be complex
+		VectorVectorType w;
+		VectorRealType weights;
+		if (target.includeGroundStage()) {
+			w.push_back(VectorType());
+			contractWithFactors(w.back(), target.gs(), lrs.super());
+			weights.push_back(target.gsWeight());
+		}
 
-			data_.setBlock(m,pBasis_.partition(m),matrixBlock);
+		for (SizeType i = 0; i < target.size(); ++i) {
+			w.push_back(VectorType());
+			contractWithFactors(w.back(), target(i), lrs.super());
+			weights.push_back(target.weight(i)/target.normSquared(i));
 		}
 
+		SizeType summedSize = pBasisSummed.size();
+		bool expandSys = (p.direction == ProgramGlobals::EXPAND_SYSTEM);
+		SizeType ns = (expandSys) ? lrs.super().size()/summedSize : summedSize;
+		typedef PsimagLite::Parallelizer<ParallelBlocks> ParallelizerType;
+		ParallelizerType threaded(PsimagLite::Concurrency::codeSectionParams);
+		ParallelBlocks helper(matrixBlocks,
+		                      w,
+		                      weights,
+		                      pBasis_,
+		                      summedSize,
+		                      ns,
+		                      expandSys);
+		threaded.loopCreate(helper);
+
+		for (SizeType m = 0; m < total; ++m)
+			data_.setBlock(m,pBasis_.partition(m),matrixBlocks[m]);
+
 		if (debug_) areAllMsEqual(pBasis_);
 	}
 
@@ -241,84 +363,34 @@ private:
 		return true;
 	}
 
-	ComplexOrRealType densityMatrixAux(SizeType alpha1,
-	                                          SizeType alpha2,
-	                                          const TargetingType& target,
-	                                          const BasisWithOperatorsType& pBasisSummed,
-	                                          const BasisType& pSE,
-	                                          ProgramGlobals::DirectionEnum direction)
-	{
-		ComplexOrRealType sum=0;
-		// The g.s. has to be treated separately because it's
-		// usually a vector of RealType, whereas
-		// the other targets might be complex,
-		// and C++ generic programming capabilities are weak... we need D!!!
-		if (target.includeGroundStage())
-			sum +=  densityMatrixHasFactors(alpha1,
-			                                alpha2,
-			                                target.gs(),
-			                                pBasisSummed,
-			                                pSE,
-			                                direction)*target.gsWeight();
-
-		for (SizeType i = 0; i < target.size(); ++i)
-			sum += densityMatrixHasFactors(alpha1,
-			                               alpha2,
-			                               target(i),
-			                               pBasisSummed,
-			                               pSE,
-			                               direction)*target.weight(i)/target.normSquared(i);
-
-		return sum;
-	}
-
+	// w(i) = sum_eta factors(i, eta) v(permutationInverse(eta)), sparse times dense
 	template<typename TargetVectorType>
-	ComplexOrRealType densityMatrixHasFactors(SizeType alpha1,
-	                                                 SizeType alpha2,
-	                                                 const TargetVectorType& v,
-	                                                 const BasisWithOperatorsType& pBasisSummed,
-	                                                 const BasisType& pSE,
-	                                                 ProgramGlobals::DirectionEnum direction)
+	void contractWithFactors(VectorType& w,
+	                         const TargetVectorType& v,
+	                         const BasisType& pSE) const
 	{
-		int ne = pBasisSummed.size();
-		int ns = pSE.size()/ne;
-		SizeType total=pBasisSummed.size();
-		if (direction != ProgramGlobals::EXPAND_SYSTEM) {
-			ns=pBasisSummed.size();
-			ne=pSE.size()/ns;
+		SizeType n = pSE.size();
+		VectorType unpermuted(n, 0.0);
+		for (SizeType ii = 0; ii < v.sectors(); ++ii) {
+			SizeType i0 = v.sector(ii);
+			SizeType offset = v.offset(i0);
+			SizeType total = v.effectiveSize(i0);
+			for (SizeType i = 0; i < total; ++i)
+				unpermuted[pSE.permutation(i + offset)] = v.fastAccess(i0, i);
 		}
 
-		ComplexOrRealType sum=0;
-
 		// Make sure we don't copy just get the reference here!!
 		const FactorsType* fptr = pSE.getFactors();
 		assert(fptr);
 		const FactorsType& factors = *fptr;
 
-		for (SizeType beta=0;beta<total;beta++) {
-			// sum over environ:
-			int i1 = alpha1+beta*ns;
-			int i2 = alpha2+beta*ns;
-			// sum over system:
-			if (direction != ProgramGlobals::EXPAND_SYSTEM) {
-				i1 = beta + alpha1*ns;
-				i2 = beta + alpha2*ns;
-			}
-			for (int k1=factors.getRowPtr(i1);k1<factors.getRowPtr(i1+1);k1++) {
-				int eta1 = factors.getCol(k1);
-				int ii = pSE.permutationInverse(eta1);
-				for (int k2=factors.getRowPtr(i2);k2<factors.getRowPtr(i2+1);k2++) {
-					int eta2 =  factors.getCol(k2);
-					int jj = pSE.permutationInverse(eta2);
-
-					ComplexOrRealType tmp3= v.slowAccess(ii)*
-					        PsimagLite::conj(v.slowAccess(jj)) *
-					        factors.getValue(k1) * factors.getValue(k2);
-					sum += tmp3;
-				}
-			}
+		w.resize(n);
+		for (SizeType i = 0; i < n; ++i) {
+			ComplexOrRealType sum = 0.0;
+			for (int k = factors.getRowPtr(i); k < factors.getRowPtr(i + 1); ++k)
+				sum += factors.getValue(k)*unpermuted[factors.getCol(k)];
+			w[i] = sum;
 		}
-		return sum;
 	}
 
 	//! only used for debugging
@@ -76,6 +76,7 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 #include "NoPthreads.h"
 #include "Concurrency.h"
 #include "MatrixVectorKron/GenIjPatch.h"
+#include "RandomizedEigs.h"
 
 namespace Dmrg {
 
@@ -104,6 +105,8 @@ class DensityMatrixSvd : public DensityMatrixBase<TargetingType> {
 	typedef std::pair<SizeType, SizeType> PairSizeType;
 	typedef typename BaseType::BlockDiagonalMatrixType BlockDiagonalMatrixType;
 	typedef typename BasisType::QnType QnType;
+	typedef RandomizedEigs<MatrixType> RandomizedEigsType;
+	typedef typename RandomizedEigsType::VectorBoolType VectorBoolType;
 
 	enum {EXPAND_SYSTEM = ProgramGlobals::EXPAND_SYSTEM };
 
@@ -353,17 +356,59 @@ class DensityMatrixSvd : public DensityMatrixBase<TargetingType> {
 
 		ParallelSvd(BlockDiagonalMatrixType& blockDiagonalMatrix,
 		            GroupsStructType& allTargets,
-		            VectorRealType& eigs)
+		            VectorRealType& eigs,
+		            VectorRealType& residuals,
+		            SizeType kept,
+		            const VectorBoolType* redo)
 		    :  blockDiagonalMatrix_(blockDiagonalMatrix),
 		      allTargets_(allTargets),
-		      eigs_(eigs)
+		      eigs_(eigs),
+		      residuals_(residuals),
+		      kept_(kept),
+		      redo_(redo)
+		{}
+
+		void doTask(SizeType ipatch, SizeType)
+		{
+			if (redo_ && !(*redo_)[ipatch]) return;
+
+			if (kept_ == 0 || redo_) {
+				svdFull(ipatch);
+				return;
+			}
+
+			SizeType igroup = allTargets_.groupFromIndex(ipatch);
+			const MatrixType& m = allTargets_.matrix(igroup);
+			SizeType k = RandomizedEigsType::rank(m.rows(), eigs_.size(), kept_);
+			if (k == 0) {
+				svdFull(ipatch);
+				return;
+			}
+
+			RandomizedEigsType randomized(m, true);
+			MatrixType u;
+			VectorRealType eigsOnePatch;
+			RealType residual = 0;
+			if (!randomized(u, eigsOnePatch, residual, k)) {
+				svdFull(ipatch);
+				return;
+			}
+
+			SizeType offset = allTargets_.basis().partition(igroup);
+			blockDiagonalMatrix_.setBlock(igroup, offset, u);
+			for (SizeType i = 0; i < eigsOnePatch.size(); ++i)
+				eigs_[i + offset] = eigsOnePatch[i];
+			residuals_[ipatch] = residual;
+		}
+
+		SizeType tasks() const
 		{
-			SizeType oneSide = allTargets.basis().size();
-			eigs_.resize(oneSide);
-			std::fill(eigs_.begin(), eigs_.end(), 0.0);
+			return allTargets_.size();
 		}
 
-		void doTask(SizeType ipatch, SizeType)
+	private:
+
+		void svdFull(SizeType ipatch)
 		{
 			SizeType igroup = allTargets_.groupFromIndex(ipatch);
 			MatrixType& m = allTargets_.matrix(igroup);
@@ -381,20 +426,17 @@ class DensityMatrixSvd : public DensityMatrixBase<TargetingType> {
 			SizeType x = eigsOnePatch.size();
 			if (x > partSize) x = partSize;
 			assert(x + offset <= eigs_.size());
-			for (SizeType i = 0; i < x; ++i)
-				eigs_[i + offset] = eigsOnePatch[i]*eigsOnePatch[i];
+			for (SizeType i = 0; i < partSize; ++i)
+				eigs_[i + offset] = (i < x) ? eigsOnePatch[i]*eigsOnePatch[i] : 0.0;
+			residuals_[ipatch] = -1;
 		}
 
-		SizeType tasks() const
-		{
-			return allTargets_.size();
-		}
-
-	private:
-
 		BlockDiagonalMatrixType& blockDiagonalMatrix_;
 		GroupsStructType& allTargets_;
 		VectorRealType& eigs_;
+		VectorRealType& residuals_;
+		SizeType kept_;
+		const VectorBoolType* redo_;
 	};
 
 public:
@@ -465,11 +507,46 @@ public:
 	void diag(VectorRealType& eigs,char jobz)
 	{
 		typedef PsimagLite::Parallelizer<ParallelSvd> ParallelizerType;
+		SizeType oneSide = allTargets_.basis().size();
+		eigs.resize(oneSide);
+		std::fill(eigs.begin(), eigs.end(), 0.0);
+		SizeType kept = (params_.partialKept < oneSide) ? params_.partialKept : 0;
+		VectorRealType residuals(allTargets_.size(), -1);
+
 		ParallelizerType threaded(PsimagLite::Concurrency::codeSectionParams);
 		ParallelSvd parallelSvd(data_,
 		                        allTargets_,
-		                        eigs);
+		                        eigs,
+		                        residuals,
+		                        kept,
+		                        0);
 		threaded.loopCreate(parallelSvd);
+
+		if (kept > 0) {
+			// full SVD of the groups where the leading states might not suffice
+			VectorBoolType redo;
+			SizeType redone = RandomizedEigsType::borderline(redo, eigs, residuals, kept);
+			if (redone > 0) {
+				ParallelizerType threaded2(PsimagLite::Concurrency::codeSectionParams);
+				ParallelSvd parallelSvd2(data_,
+				                         allTargets_,
+				                         eigs,
+				                         residuals,
+				                         kept,
+				                         &redo);
+				threaded2.loopCreate(parallelSvd2);
+			}
+
+			SizeType partial = 0;
+			for (SizeType i = 0; i < residuals.size(); ++i)
+				if (residuals[i] >= 0) ++partial;
+
+			PsimagLite::OstringStream msg;
+			msg<<"truncationRandomized: "<<partial<<" of "<<residuals.size();
+			msg<<" groups done partially, "<<redone<<" borderline groups redone fully";
+			progress_.printline(msg,std::cout);
+		}
+
 		for (SizeType i = 0; i < data_.blocks(); ++i) {
 			SizeType n = data_(i).rows();
 			if (n > 0) continue;
@@ -1,6 +1,11 @@
 #ifndef DIAGBLOCKDIAGMATRIX_H
 #define DIAGBLOCKDIAGMATRIX_H
 #include "EnforcePhase.h"
+#include "Concurrency.h"
+#include "Parallelizer.h"
+#include "PsimagLite.h"
+#include "ParallelWeights.h"
+#include <algorithm>
 
 namespace Dmrg {
 
@@ -10,6 +15,8 @@ class DiagBlockDiagMatrix {
 	typedef typename BlockDiagonalMatrixType::BuildingBlockType BuildingBlockType;
 	typedef typename BuildingBlockType::value_type ComplexOrRealType;
 	typedef typename BlockDiagonalMatrixType::VectorRealType VectorRealType;
+	typedef typename PsimagLite::Vector<SizeType>::Type VectorSizeType;
+	typedef ParallelWeights::VectorLongType VectorLongType;
 
 	class LoopForDiag {
 
@@ -28,20 +35,53 @@ class DiagBlockDiagMatrix {
 		{
 
 			for (SizeType m=0;m<C.blocks();m++) {
-				eigsForGather[m].resize(C.offsetsRows(m+1)-C.offsetsRows(m));
-				weights[m] =  C.offsetsRows(m+1)-C.offsetsRows(m);
+				SizeType n = C.offsetsRows(m+1)-C.offsetsRows(m);
+				eigsForGather[m].resize(n);
+				weights[m] = static_cast<long unsigned int>(n)*n*n;
 			}
 
 			assert(C.rows() == C.cols());
 			eigs.resize(C.rows());
 		}
 
-		SizeType tasks() const { return C.blocks(); }
+		// Splits the blocks by cost: returns the ones costlier than an even share
+		// per thread, and keeps the rest, with their weights, as this loop's tasks
+		void split(VectorSizeType& large, SizeType nthreads)
+		{
+			long unsigned int total = 0;
+			for (SizeType m = 0; m < weights.size(); ++m)
+				total += weights[m];
+
+			long unsigned int share = (nthreads > 1) ? total/nthreads : 0;
+			VectorLongType smallWeights;
+			for (SizeType m = 0; m < weights.size(); ++m) {
+				if (weights[m] == 0) continue;
+				if (weights[m] > share) {
+					large.push_back(m);
+				} else {
+					blocks.push_back(m);
+					smallWeights.push_back(weights[m]);
+				}
+			}
+
+			// largest first, so that each one gets the whole node in turn
+			std::sort(large.begin(), large.end(), CompareWeights(weights));
+			ParallelWeights::fromCosts(weightsForTasks, smallWeights);
+		}
+
+		SizeType tasks() const { return blocks.size(); }
+
+		const VectorSizeType& weightsOfTasks() const { return weightsForTasks; }
 
 		void doTask(SizeType taskNumber, SizeType)
+		{
+			assert(taskNumber < blocks.size());
+			diagOne(blocks[taskNumber]);
+		}
+
+		void diagOne(SizeType m)
 		{
 			assert(C.rows() == C.cols());
-			SizeType m = taskNumber;
 			VectorRealType eigsTmp;
 			C.diagAndEnforcePhase(m, eigsTmp, option);
 			for (SizeType j = C.offsetsRows(m); j < C.offsetsRows(m+1); ++j)
@@ -60,36 +100,58 @@ class DiagBlockDiagMatrix {
 
 	private:
 
+		class CompareWeights {
+
+		public:
+
+			CompareWeights(const VectorLongType& w) : w_(w) {}
+
+			bool operator()(SizeType a, SizeType b) const { return (w_[a] > w_[b]); }
+
+		private:
+
+			const VectorLongType& w_;
+		};
+
 		BlockDiagonalMatrixType& C;
 		VectorRealType& eigs;
 		char option;
 		typename PsimagLite::Vector<VectorRealType>::Type eigsForGather;
-		typename PsimagLite::Vector<SizeType>::Type weights;
+		VectorLongType weights;
+		VectorSizeType blocks;
+		VectorSizeType weightsForTasks;
 	};
 
 public:
 
 	// Parallel version of the diagonalization of a block diagonal matrix
-	// Note: In reality, Parallelization is disabled here because a LAPACK call
-	//        is needed and LAPACK is not necessarily thread safe.
+	// Blocks costing (n^3) more than an even share per thread are done first,
+	// one at a time, so that a threaded LAPACK can use the whole node for each;
+	// the remaining blocks are done concurrently, one LAPACK call per thread,
+	// each with its own workspace, and scheduled by cost.
+	// Threads=1 in the input recovers the serial behavior.
 	// This function is NOT called by useSvd
 	static void diagonalise(BlockDiagonalMatrixType& C,
 	                        VectorRealType& eigs,
 	                        char option)
 	{
-		typedef PsimagLite::NoPthreadsNg<LoopForDiag> ParallelizerType;
+		typedef PsimagLite::Parallelizer<LoopForDiag> ParallelizerType;
 		typedef PsimagLite::Concurrency ConcurrencyType;
-		SizeType savedNpthreads = ConcurrencyType::codeSectionParams.npthreads;
-		ConcurrencyType::codeSectionParams.npthreads = 1;
-		ParallelizerType threadObject(ConcurrencyType::codeSectionParams);
 
 		LoopForDiag helper(C,eigs,option);
 
-		threadObject.loopCreate(helper); // FIXME: needs weights
+		VectorSizeType large;
+		helper.split(large, ConcurrencyType::codeSectionParams.npthreads);
 
-		helper.gather();
+		for (SizeType i = 0; i < large.size(); ++i)
+			helper.diagOne(large[i]);
+
+		if (helper.tasks() > 0) {
+			ParallelizerType threadObject(ConcurrencyType::codeSectionParams);
+			threadObject.loopCreate(helper, helper.weightsOfTasks());
+		}
 
-		ConcurrencyType::codeSectionParams.npthreads = savedNpthreads;
+		helper.gather();
 	}
 }; // class DiagBlockDiagMatrix
 
@@ -83,6 +83,7 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 #include "ProgramGlobals.h"
 #include "LanczosSolver.h"
 #include "DavidsonSolver.h"
+#include "LanczosThickRestart.h"
 #include "ParametersForSolver.h"
 #include "Concurrency.h"
 
@@ -125,6 +126,8 @@ public:
 	typedef PsimagLite::LanczosSolver<ParametersForSolverType,
 	MatrixVectorType,
 	TargetVectorType> LanczosSolverType;
+	typedef LanczosThickRestart<typename LanczosOrDavidsonBaseType::MatrixType,
+	TargetVectorType> LanczosThickRestartType;
 
 	Diagonalization(const ParametersType& parameters,
 	                const ModelType& model,
@@ -470,7 +473,11 @@ private:
 		if (!reflectionOperator_.isEnabled()) {
 			tmpVec.resize(lanczosHelper.rows());
 			try {
-				energyTmp = computeLevel(*lanczosOrDavidson,tmpVec,initialVector);
+				energyTmp = computeLevel(*lanczosOrDavidson,
+				                         lanczosHelper,
+				                         params,
+				                         tmpVec,
+				                         initialVector);
 			} catch (std::exception& e) {
 				PsimagLite::OstringStream msg0;
 				msg0<<e.what()<<"\n";
@@ -498,14 +505,22 @@ private:
 		TargetVectorType initialVector1,initialVector2;
 		reflectionOperator_.setInitState(initialVector,initialVector1,initialVector2);
 		tmpVec.resize(initialVector1.size());
-		energyTmp = computeLevel(*lanczosOrDavidson,tmpVec,initialVector1);
+		energyTmp = computeLevel(*lanczosOrDavidson,
+		                         lanczosHelper,
+		                         params,
+		                         tmpVec,
+		                         initialVector1);
 
 		RealType gsEnergy1 = energyTmp;
 		TargetVectorType gsVector1 = tmpVec;
 
 		lanczosHelper.reflectionSector(1);
 		TargetVectorType gsVector2(initialVector2.size());
-		RealType gsEnergy2 = computeLevel(*lanczosOrDavidson,gsVector2,initialVector2);
+		RealType gsEnergy2 = computeLevel(*lanczosOrDavidson,
+		                                  lanczosHelper,
+		                                  params,
+		                                  gsVector2,
+		                                  initialVector2);
 
 		energyTmp=reflectionOperator_.setGroundState(tmpVec,
 		                                             gsEnergy1,
@@ -516,6 +531,25 @@ private:
 		if (lanczosOrDavidson) delete lanczosOrDavidson;
 	}
 
+	RealType computeLevel(LanczosOrDavidsonBaseType& object,
+	                      const typename LanczosOrDavidsonBaseType::MatrixType& lanczosHelper,
+	                      const ParametersForSolverType& params,
+	                      TargetVectorType &gsVector,
+	                      const TargetVectorType &initialVector) const
+	{
+		if (parameters_.lanczosMaxVectors == 0)
+			return computeLevel(object, gsVector, initialVector);
+
+		// memory-bounded alternative; excited states are rejected by the parameters
+		LanczosThickRestartType lanczosThick(lanczosHelper,
+		                                     parameters_.lanczosMaxVectors,
+		                                     params.steps,
+		                                     params.tolerance);
+		RealType gsEnergy = 0;
+		lanczosThick.computeGroundState(gsEnergy, gsVector, initialVector);
+		return gsEnergy;
+	}
+
 	RealType computeLevel(LanczosOrDavidsonBaseType& object,
 	                      TargetVectorType &gsVector,
 	                      const TargetVectorType &initialVector) const
@@ -75,16 +75,82 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 // All these includes are in PsimagLite
 #include "Stack.h"
 #include "Io/IoNg.h"
+#include "ProgramGlobals.h"
 #include "ProgressIndicator.h"
 #include <exception>
+#include <algorithm>
 
 // A disk stack, similar to std::stack but stores in disk not in memory
+// Records are only appended: a push after a pop writes a new record, and
+// the stack is an index of records that is kept in memory and saved,
+// together with the size, by close(), or when the stack is destroyed
+// if it was not closed. Until then the file reads as an empty stack.
+// An entry can also be a reference to a record of the same stack in
+// another file; each file carries a tag, and a reference is valid only
+// while the other file still has the tag it had when it was referenced.
 namespace Dmrg {
+
+class DiskStackReferences {
+
+	typedef PsimagLite::IoNg::In IoInType;
+	typedef PsimagLite::Vector<SizeType>::Type VectorSizeType;
+
+public:
+
+	static PsimagLite::String fullLabel(PsimagLite::String label)
+	{
+		return "DiskStack" + label;
+	}
+
+	// all files referenced by stack label in filename exist and
+	// have the expected tags
+	static bool valid(PsimagLite::String filename, PsimagLite::String label)
+	{
+		PsimagLite::String fl = fullLabel(label);
+		try {
+			IoInType io(filename);
+			SizeType n = 0;
+			try {
+				io.read(n, fl + "/Files/Size");
+			} catch (...) {
+				return true; // written before references existed
+			}
+
+			if (n == 0) return true;
+
+			VectorSizeType tags;
+			io.read(tags, fl + "/FileTags");
+			for (SizeType i = 0; i < n; ++i) {
+				PsimagLite::String file;
+				io.read(file, fl + "/Files/" + ttos(i));
+				if (i >= tags.size() || tag(file, label) != tags[i]) return false;
+			}
+
+			io.close();
+		} catch (...) {
+			return false;
+		}
+
+		return true;
+	}
+
+	static SizeType tag(PsimagLite::String filename, PsimagLite::String label)
+	{
+		IoInType io(filename);
+		SizeType t = 0;
+		io.read(t, fullLabel(label) + "/Tag");
+		io.close();
+		return t;
+	}
+};
+
 template<typename DataType>
 class DiskStack {
 
 	typedef typename PsimagLite::IoNg::In IoInType;
 	typedef typename PsimagLite::IoNg::Out IoOutType;
+	typedef PsimagLite::Vector<SizeType>::Type VectorSizeType;
+	typedef PsimagLite::Vector<PsimagLite::String>::Type VectorStringType;
 
 public:
 
@@ -94,11 +160,17 @@ public:
 	          bool isObserveCode)
 	    : ioOut_((needsToRead) ? 0 : new IoOutType(filename, PsimagLite::IoNg::ACC_RDW)),
 	      ioIn_((needsToRead) ? new IoInType(filename) : 0),
-	      label_("DiskStack" + label),
+	      filename_(filename),
+	      label_(DiskStackReferences::fullLabel(label)),
+	      shortLabel_(label),
 	      isObserveCode_(isObserveCode),
 	      total_(0),
+	      records_(0),
+	      tag_(0),
 	      progress_("DiskStack"),
-	      dt_(0)
+	      dt_(0),
+	      dtRecord_(0),
+	      dtFile_(0)
 	{
 		if (!needsToRead) {
 			ioOut_->createGroup(label_);
@@ -107,6 +179,7 @@ public:
 		}
 
 		ioIn_->read(total_, label_ + "/Size");
+		readIndex();
 		PsimagLite::OstringStream msg;
 		msg<<"Read from file " + filename + " succeeded";
 		progress_.printline(msg,std::cout);
@@ -114,10 +187,26 @@ public:
 
 	~DiskStack()
 	{
+		try {
+			close();
+		} catch (std::exception& e) {
+			std::cerr<<"DiskStack: could not save index of "<<label_<<": ";
+			std::cerr<<e.what()<<"\n";
+		}
+
 		delete dt_;
 		dt_ = 0;
 		delete ioIn_;
 		ioIn_ = 0;
+	}
+
+	// saves size and index, and closes the file for writing; errors
+	// are thrown here, unlike in the destructor, which only reports them
+	void close()
+	{
+		if (!ioOut_) return;
+
+		writeIndex();
 		delete ioOut_;
 		ioOut_ = 0;
 	}
@@ -128,24 +217,35 @@ public:
 	{
 		assert(ioOut_);
 
-		try {
-			d.write(*ioOut_,
-			        label_ + "/" + ttos(total_),
-			        IoOutType::Serializer::NO_OVERWRITE,
-			        DataType::SAVE_ALL);
-		} catch (std::exception&) {
-			d.write(*ioOut_,
-			        "/" + ttos(total_),
-			        IoOutType::Serializer::ALLOW_OVERWRITE,
-			        DataType::SAVE_ALL);
-		}
+		d.write(*ioOut_,
+		        label_ + "/" + ttos(records_),
+		        IoOutType::Serializer::NO_OVERWRITE,
+		        saveOption());
 
+		index_.push_back(records_++);
+		fileOf_.push_back(0);
 		++total_;
+	}
 
-		ioOut_->write(total_,
-		              label_ + "/Size",
-		              IoOutType::Serializer::ALLOW_OVERWRITE);
+	// pushes record of this stack in file, which must have tag
+	void pushReference(PsimagLite::String file, SizeType tag, SizeType record)
+	{
+		assert(ioOut_);
+
+		SizeType k = 0;
+		for (; k < files_.size(); ++k)
+			if (files_[k] == file) break;
+
+		if (k == files_.size()) {
+			files_.push_back(file);
+			fileTags_.push_back(tag);
+		} else if (fileTags_[k] != tag) {
+			err("DiskStack: " + file + " referenced with two different tags\n");
+		}
 
+		index_.push_back(record);
+		fileOf_.push_back(k + 1);
+		++total_;
 	}
 
 	void pop()
@@ -154,43 +254,153 @@ public:
 			err("Can't pop; the stack is empty!\n");
 
 		--total_;
-
-		if (!ioOut_) return;
-
-		ioOut_->write(total_,
-		              label_ + "/Size",
-		              IoOutType::Serializer::ALLOW_OVERWRITE);
+		index_.pop_back();
+		fileOf_.pop_back();
 	}
 
+	// the deserialized top is kept until a different record is the top
 	const DataType& top() const
 	{
 		if (!ioIn_)
 			err("DiskStack::top() called with ioIn_ as nullptr\n");
 
 		assert(total_ > 0);
+		SizeType record = index_[total_ - 1];
+		SizeType file = fileOf_[total_ - 1];
+		if (dt_ && dtRecord_ == record && dtFile_ == file) return *dt_;
+
 		delete dt_;
 		dt_ = 0;
-		dt_ = new DataType(*ioIn_,
-		                   label_ + "/" + ttos(total_ - 1),
-		                   isObserveCode_);
+		PsimagLite::String name(label_ + "/" + ttos(record));
+		if (file == 0) {
+			dt_ = new DataType(*ioIn_, name, isObserveCode_);
+		} else {
+			assert(file - 1 < files_.size());
+			const PsimagLite::String& otherFile = files_[file - 1];
+			if (DiskStackReferences::tag(otherFile, shortLabel_) != fileTags_[file - 1])
+				err("DiskStack: " + otherFile + " has changed since referenced\n");
+			IoInType io(otherFile);
+			dt_ = new DataType(io, name, isObserveCode_);
+			io.close();
+		}
+
+		dtRecord_ = record;
+		dtFile_ = file;
 		return *dt_;
 	}
 
 	SizeType size() const { return total_; }
 
+	// record of the top entry in the file that holds it
+	SizeType recordOfTop() const
+	{
+		assert(total_ > 0);
+		return index_[total_ - 1];
+	}
+
+	void setTag(SizeType tag) { tag_ = tag; }
+
+	// file and group that hold the entry at pos, 0 being the bottom
+	void locationOf(SizeType pos,
+	                PsimagLite::String& file,
+	                PsimagLite::String& group) const
+	{
+		assert(pos < static_cast<SizeType>(total_));
+		group = label_ + "/" + ttos(index_[pos]);
+		SizeType f = fileOf_[pos];
+		if (f == 0) {
+			file = filename_;
+			return;
+		}
+
+		assert(f - 1 < files_.size());
+		file = files_[f - 1];
+		if (DiskStackReferences::tag(file, shortLabel_) != fileTags_[f - 1])
+			err("DiskStack: " + file + " has changed since referenced\n");
+	}
+
 private:
 
 	DiskStack(const DiskStack&);
 
 	DiskStack& operator=(const DiskStack&);
 
+	static SizeType saveOption()
+	{
+		return (ProgramGlobals::stacksSinglePrecision) ? DataType::SAVE_ALL_SINGLE :
+		                                                 DataType::SAVE_ALL;
+	}
+
+	// files written before the index existed have record i at position i
+	void readIndex()
+	{
+		index_.clear();
+		try {
+			ioIn_->read(index_, label_ + "/Index");
+		} catch (...) {}
+
+		if (index_.size() != static_cast<SizeType>(total_)) {
+			index_.resize(total_);
+			for (int i = 0; i < total_; ++i)
+				index_[i] = i;
+		}
+
+		fileOf_.clear();
+		try {
+			ioIn_->read(fileOf_, label_ + "/FileOf");
+		} catch (...) {}
+
+		if (fileOf_.size() != static_cast<SizeType>(total_)) {
+			fileOf_.resize(total_);
+			std::fill(fileOf_.begin(), fileOf_.end(), 0);
+			return;
+		}
+
+		SizeType n = 0;
+		ioIn_->read(n, label_ + "/Files/Size");
+		if (n > 0) ioIn_->read(fileTags_, label_ + "/FileTags");
+		files_.resize(n);
+		for (SizeType i = 0; i < n; ++i)
+			ioIn_->read(files_[i], label_ + "/Files/" + ttos(i));
+	}
+
+	void writeIndex() const
+	{
+		if (!ioOut_) return;
+
+		ioOut_->write(total_,
+		              label_ + "/Size",
+		              IoOutType::Serializer::ALLOW_OVERWRITE);
+		ioOut_->write(tag_, label_ + "/Tag");
+		if (total_ == 0) return;
+
+		ioOut_->write(index_, label_ + "/Index");
+		ioOut_->write(fileOf_, label_ + "/FileOf");
+		SizeType nfiles = files_.size();
+		ioOut_->createGroup(label_ + "/Files");
+		ioOut_->write(nfiles, label_ + "/Files/Size");
+		for (SizeType i = 0; i < files_.size(); ++i)
+			ioOut_->write(files_[i], label_ + "/Files/" + ttos(i));
+		if (files_.size() > 0) ioOut_->write(fileTags_, label_ + "/FileTags");
+	}
+
 	IoOutType* ioOut_;
 	IoInType* ioIn_;
+	PsimagLite::String filename_;
 	PsimagLite::String label_;
+	PsimagLite::String shortLabel_;
 	bool isObserveCode_;
 	int total_;
+	SizeType records_;
+	SizeType tag_;
+	VectorSizeType index_;
+	VectorSizeType fileOf_;
+	VectorStringType files_;
+	VectorSizeType fileTags_;
 	PsimagLite::ProgressIndicator progress_;
 	mutable DataType* dt_;
+	mutable SizeType dtRecord_;
+	mutable SizeType dtFile_;
 }; // class DiskStack
 
 } // namespace Dmrg
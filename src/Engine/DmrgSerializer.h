@@ -211,6 +211,23 @@ public:
 		m.toSparse(ret);
 	}
 
+	// approximate memory in bytes, as read by the observer
+	long unsigned int memory() const
+	{
+		long unsigned int n = 0;
+		for (SizeType i = 0; i < wavefunction_.sectors(); ++i)
+			n += wavefunction_.effectiveSize(wavefunction_.sector(i));
+
+		for (SizeType i = 0; i < transform_.blocks(); ++i)
+			n += static_cast<long unsigned int>(transform_(i).rows())*transform_(i).cols();
+
+		// permutations, electrons and quantum numbers of the bases
+		long unsigned int states = lrs_.left().size();
+		states += lrs_.right().size();
+		states += lrs_.super().size();
+		return n*sizeof(ComplexOrRealType) + 4*states*sizeof(SizeType);
+	}
+
 private:
 
 	void fillOffsets(VectorSizeType& v, const BasisType& basis) const
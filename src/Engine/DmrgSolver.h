@@ -102,6 +102,7 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 #include "PsiBase64.h"
 #include "PrinterInDetail.h"
 #include "Io/IoSelector.h"
+#include "IoWriteQueue.h"
 
 namespace Dmrg {
 
@@ -161,6 +162,7 @@ public:
 	typedef typename BasisWithOperatorsType::BlockDiagonalMatrixType BlockDiagonalMatrixType;
 	typedef typename BasisWithOperatorsType::QnType QnType;
 	typedef typename QnType::PairSizeType PairSizeType;
+	typedef IoWriteQueue<PsimagLite::IoSelector::Out> IoWriteQueueType;
 
 	enum {SAVE_ALL=MyBasis::SAVE_ALL, SAVE_PARTIAL=MyBasis::SAVE_PARTIAL};
 
@@ -173,6 +175,7 @@ public:
 	      verbose_(false),
 	      lrs_("pSprime", "pEprime", "pSE"),
 	      ioOut_(parameters_.filename, PsimagLite::IoSelector::ACC_TRUNC),
+	      ioQueue_(ioOut_, outputQueueLength(parameters_)),
 	      progress_("DmrgSolver"),
 	      quantumSector_(0, VectorSizeType(), PairSizeType(0, 0), 0),
 	      stepCurrent_(0),
@@ -194,7 +197,7 @@ public:
 	                wft_,
 	                parameters_,
 	                model.geometry(),
-	                ioOut_),
+	                ioQueue_),
 	      energy_(0.0),
 	      saveData_(parameters_.options.find("noSaveData") == PsimagLite::String::npos)
 	{
@@ -211,6 +214,10 @@ public:
 
 		if (parameters_.options.find("verbose")!=PsimagLite::String::npos)
 			verbose_=true;
+
+		ProgramGlobals::stacksSinglePrecision =
+		        (parameters_.options.find("stacksSinglePrecision") !=
+		        PsimagLite::String::npos);
 	}
 
 	~DmrgSolver()
@@ -218,7 +225,7 @@ public:
 		SizeType site = 0; // FIXME FOR IMMM
 		VectorSizeType electrons;
 		model_.findElectronsOfOneSite(electrons, site);
-		ioOut_.write(electrons, "ElectronsOneSite");
+		ioOut().write(electrons, "ElectronsOneSite");
 
 		appInfo_.finalize();
 		ioOut_.write(appInfo_, "ApplicationInfo");
@@ -231,7 +238,7 @@ public:
 
 	void main(const GeometryType& geometry, PsimagLite::String targeting)
 	{
-		ioOut_.write(geometry, "GEOMETRY");
+		ioOut().write(geometry, "GEOMETRY");
 
 		BlockType S,E;
 		VectorBlockType X,Y;
@@ -272,6 +279,8 @@ public:
 			throw PsimagLite::RuntimeError("Unknown targeting " + targeting + "\n");
 		}
 
+		psi->setWriteQueue(&ioQueue_);
+
 		ioIn_.printUnused(std::cerr);
 
 		MyBasisWithOperators pS("BasisWithOperators.System");
@@ -288,7 +297,7 @@ public:
 			infiniteDmrgLoop(X,Y,E,pS,pE,*psi);
 		}
 
-		RecoveryType recovery(sitesIndices_, ioOut_, checkpoint_, wft_, pS, pE);
+		RecoveryType recovery(sitesIndices_, ioOut(), checkpoint_, wft_, pS, pE);
 		finiteDmrgLoops(pS, pE, *psi, recovery);
 
 		inSitu_.init(*psi,geometry.numberOfSites());
@@ -473,16 +482,16 @@ obtain ordered
 			if (psi.end()) break;
 
 			if (recovery.byLoop(i))
-				recovery.write(psi, i + 1, stepCurrent_, lastSign, ioOut_);
+				recovery.write(psi, i + 1, stepCurrent_, lastSign, ioOut());
 		}
 
 		if (!saveData_) return;
 
-		checkpoint_.write(pS, pE, ioOut_);
+		checkpoint_.write(pS, pE, ioOut());
 
-		ioOut_.createGroup("FinalPsi");
+		ioOut().createGroup("FinalPsi");
 		psi.write(sitesIndices_[stepCurrent_], ioOut_, "FinalPsi");
-		ioOut_.write(lastSign, "LastLoopSign");
+		ioOut().write(lastSign, "LastLoopSign");
 	}
 
 	void finiteStep(MyBasisWithOperators &pS,
@@ -518,10 +527,10 @@ obtain ordered
 			printerInDetail.print(std::cout, "finite");
 			if (direction == ProgramGlobals::EXPAND_SYSTEM) {
 				lrs_.growLeftBlock(model_,pS,sitesIndices_[stepCurrent_],time);
-				lrs_.right(checkpoint_.shrink(ProgramGlobals::ENVIRON,target));
+				checkpoint_.shrink(ProgramGlobals::ENVIRON, target, lrs_.rightNonConst());
 			} else {
 				lrs_.growRightBlock(model_,pE,sitesIndices_[stepCurrent_],time);
-				lrs_.left(checkpoint_.shrink(ProgramGlobals::SYSTEM,target));
+				checkpoint_.shrink(ProgramGlobals::SYSTEM, target, lrs_.leftNonConst());
 			}
 
 			lrs_.printSizes("finite",std::cout);
@@ -557,9 +566,10 @@ obtain ordered
 			progress_.printMemoryUsage();
 
 			if (target.end()) break;
+			recovery.collectBackgroundWrite();
 			if (recovery.byTime()) {
 				int lastSign = (parameters_.finiteLoop[loopIndex].stepLength < 0) ? -1 : 1;
-				recovery.write(target, loopIndex, stepCurrent_, lastSign, ioOut_);
+				recovery.write(target, loopIndex, stepCurrent_, lastSign, ioOut());
 			}
 		}
 
@@ -605,15 +615,31 @@ obtain ordered
 		if (!saveData_) return;
 
 		const BlockDiagonalMatrixType& transform = truncate_.transform(direction);
-		DmrgSerializerType ds(fsS,fsE,lrs_,target.gs(),transform, direction);
-
 		SizeType saveOption2 = (saveOption & 4) ? SAVE_ALL : SAVE_PARTIAL;
+
+		// DmrgSerializer shares the blocks of the LeftRightSuper it is given,
+		// and lrs_ changes in the next step; a queued job gets its own copy,
+		// with the operators only if they are to be saved
+		LeftRightSuperType* lrsCopy = 0;
+		if (ioQueue_.inBackground()) {
+			lrsCopy = new LeftRightSuperType(lrs_.left().name(),
+			                                 lrs_.right().name(),
+			                                 lrs_.super().name());
+			lrsCopy->copyForWrite(lrs_, saveOption2);
+		}
+
+		DmrgSerializerType* ds = new DmrgSerializerType(fsS,
+		                                                fsE,
+		                                                (lrsCopy) ? *lrsCopy : lrs_,
+		                                                target.gs(),
+		                                                transform,
+		                                                direction);
+
 		SizeType numberOfSites = model_.geometry().numberOfSites();
 
 		static SizeType counter = 0;
-		PsimagLite::String prefix("Serializer");
-		ds.write(ioOut_, prefix, saveOption2, numberOfSites, counter);
-		PsimagLite::String prefixForTarget = TargetingType::buildPrefix(ioOut_, counter);
+		ioQueue_.push(new SerializerJob(ds, lrsCopy, saveOption2, numberOfSites, counter));
+		PsimagLite::String prefixForTarget = TargetingType::prefixFor(counter);
 		target.write(sitesIndices_[stepCurrent_], ioOut_, prefixForTarget);
 		++counter;
 	}
@@ -670,6 +696,7 @@ obtain ordered
 		if (!saveData_) return;
 		static SizeType counter = 0;
 		if (counter == 0) {
+			ioQueue_.drain();
 			try {
 				PsimagLite::IoSelector::In ioIn(ioOut_.filename());
 				SizeType x = 0;
@@ -679,9 +706,67 @@ obtain ordered
 			} catch (...) {}
 		}
 
-		ioOut_.writeVectorEntry(energy, "Energy", counter++);
+		ioQueue_.writeVectorEntry(energy, "Energy", counter++);
+	}
+
+	// anything queued is written first
+	PsimagLite::IoSelector::Out& ioOut()
+	{
+		ioQueue_.drain();
+		return ioOut_;
 	}
 
+	// with outputInBackground, output of a few steps can be queued
+	static SizeType outputQueueLength(const ParametersType& parameters)
+	{
+		bool inBackground = (parameters.options.find("outputInBackground") !=
+		        PsimagLite::String::npos);
+		return (inBackground) ? 16 : 0;
+	}
+
+	// one step of DmrgSerializer data, and the group for the target;
+	// owns ds and lrs, the blocks that ds refers to, if any
+	class SerializerJob : public IoWriteQueueType::Job {
+
+	public:
+
+		SerializerJob(DmrgSerializerType* ds,
+		              LeftRightSuperType* lrs,
+		              SizeType option,
+		              SizeType numberOfSites,
+		              SizeType counter)
+		    : ds_(ds),
+		      lrs_(lrs),
+		      option_(option),
+		      numberOfSites_(numberOfSites),
+		      counter_(counter)
+		{}
+
+		~SerializerJob()
+		{
+			delete ds_;
+			delete lrs_;
+		}
+
+		void write(PsimagLite::IoSelector::Out& io)
+		{
+			ds_->write(io, "Serializer", option_, numberOfSites_, counter_);
+			TargetingType::buildPrefix(io, counter_);
+		}
+
+	private:
+
+		SerializerJob(const SerializerJob&);
+
+		SerializerJob& operator=(const SerializerJob&);
+
+		DmrgSerializerType* ds_;
+		LeftRightSuperType* lrs_;
+		SizeType option_;
+		SizeType numberOfSites_;
+		SizeType counter_;
+	};
+
 	const BlockType& findRightBlock(const VectorBlockType& y,
 	                                SizeType step,
 	                                const BlockType& E) const
@@ -698,6 +783,7 @@ obtain ordered
 	bool verbose_;
 	LeftRightSuperType lrs_;
 	PsimagLite::IoSelector::Out ioOut_;
+	IoWriteQueueType ioQueue_;
 	PsimagLite::ProgressIndicator progress_;
 	QnType quantumSector_;
 	int stepCurrent_;
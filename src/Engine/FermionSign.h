@@ -100,11 +100,12 @@ public:
 	template<typename SomeBasisType>
 	FermionSign(const SomeBasisType& basis,const VectorSizeType& electrons)
 	{
-		if (basis.oldSigns().size() != basis.permutationInverse().size())
+		const VectorBoolType oldSigns = basis.oldSigns();
+		if (oldSigns.size() != basis.permutationInverse().size())
 			err("FermionSign: Problem\n");
 
-		SizeType n = basis.oldSigns().size();
-		SizeType nx = basis.oldSigns().size()/electrons.size();
+		SizeType n = oldSigns.size();
+		SizeType nx = oldSigns.size()/electrons.size();
 		PackIndicesType pack(nx);
 		signs_.resize(nx);
 		for (SizeType x = 0; x < n; ++x) {
@@ -112,7 +113,7 @@ public:
 			SizeType x1 = 0;
 			pack.unpack(x0, x1, basis.permutation(x));
 			assert(x1 < electrons.size());
-			bool parity1 = basis.oldSigns()[x];
+			bool parity1 = oldSigns[x];
 			bool parity2 = (electrons[x1] & 1);
 			assert(x0 < signs_.size());
 			signs_[x0] = (parity1 != parity2);
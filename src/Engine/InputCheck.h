@@ -201,6 +201,9 @@ public:
 		knownLabels_.push_back("ThreadsStackSize");
 		knownLabels_.push_back("RecoverySave");
 		knownLabels_.push_back("RecoveryMaxFiles");
+		knownLabels_.push_back("LanczosMaxVectors");
+		knownLabels_.push_back("OperatorsDropTolerance");
+		knownLabels_.push_back("ObserverCacheMegabytes");
 		for (SizeType i = 0; i < 10; ++i)
 			knownLabels_.push_back("Term" + ttos(i));
 	}
@@ -326,6 +329,19 @@ public:
 			\item[allPvectors] TBW
 			\item[printgeometry] TBW
 			\item[recoveryEnableRead] Enables recovery if previous run crashed
+			\item[recoveryInBackground] Write the system and environment stacks
+			                  of a recovery file in a background thread, from a
+			                  snapshot, while the sweep goes on. Needs
+			                  USE_PTHREADS and a thread-safe HDF5; otherwise the
+			                  stacks are written in the main thread.
+			\item[outputInBackground] Write the data of each step to the output
+			                  file in a background thread, from copies, while the
+			                  sweep goes on. At most a few steps are queued; the
+			                  queue is emptied before checkpoints, recovery saves,
+			                  and at exit. Needs USE_PTHREADS and a thread-safe
+			                  HDF5, because with stacksInDisk or
+			                  recoveryInBackground other threads use HDF5 too;
+			                  otherwise the output is written in the main thread.
 			\item[neverNormalizeVectors] TBW
 			\item [advanceUnrestricted] Don't restrict advance time to borders
 			\item [findSymmetrySector] Find symmetry sector with lowest energy, and
@@ -334,9 +350,36 @@ public:
 			\item [extendedPrint] TBW
 			\item [truncationNoSvd] Do not use SVD for truncation;
 		                               use density matrix instead
+			\item [truncationRandomized] For symmetry blocks much larger than their
+			                  share of kept states, compute only the leading
+			                  states with a randomized range finder; blocks whose
+			                  weight not captured might reach the kept states are
+			                  diagonalized fully. The states not computed in a
+			                  block share its weight not captured evenly, so the
+			                  entropies printed and the eigenvalues saved by
+			                  saveDensityMatrixEigenvalues are approximate; the
+			                  truncation error is not. Not available with SU(2).
+			\item [stacksInDisk] Keep only the top two blocks of the system and
+			                  environment stacks in memory, and save the others
+			                  to scratch files next to the output file. The block
+			                  to be popped next is read in a background thread
+			                  if compiled with USE_PTHREADS and HDF5 is
+			                  thread-safe, and when needed otherwise. The stacks
+			                  of transformations of the WFT are kept the same way.
+			\item [stacksSinglePrecision] Save the operators and Hamiltonian of the
+			                  blocks of the system and environment stacks in single
+			                  precision, and promote them back when read. Only
+			                  disk use is halved: memory use does not change,
+			                  because the blocks held in memory, and those read
+			                  back, are in double precision. Stored values are
+			                  rounded to about 1e-7 relative. Not used with SU(2).
 			\item [KronNoLoadBalance] Disable load balancing for MatrixVectorKron
 			\item [setAffinities] TBW
 			\item [wftNoAccel] Disable WFT acceleration (but not the WFT itself)
+			\item [wftInfinite] Use the previous ground state, transformations, and
+			                  center matrix to predict the initial guess during the
+			                  infinite algorithm. Not available with SU(2). Not
+			                  available with wftNoAccel unless twositedmrg is set.
 			\item [BatchedGemm] Only meaningful with MatrixVectorKron. Enables
 								batched gemm and might need plugin sc
 			\item [KrylovAbridge] TBW
@@ -385,9 +428,13 @@ public:
 		registerOpts.push_back("allPvectors");
 		registerOpts.push_back("printgeometry");
 		registerOpts.push_back("recoveryEnableRead");
+		registerOpts.push_back("recoveryInBackground");
+		registerOpts.push_back("outputInBackground");
 		registerOpts.push_back("normalizeTimeVectors");
 		registerOpts.push_back("neverNormalizeVectors");
 		registerOpts.push_back("noSaveStacks");
+		registerOpts.push_back("stacksInDisk");
+		registerOpts.push_back("stacksSinglePrecision");
 		registerOpts.push_back("noSaveData");
 		registerOpts.push_back("noSaveWft");
 		registerOpts.push_back("minimizeDisk");
@@ -397,9 +444,11 @@ public:
 		registerOpts.push_back("doNotCheckTwoSiteDmrg");
 		registerOpts.push_back("extendedPrint");
 		registerOpts.push_back("truncationNoSvd");
+		registerOpts.push_back("truncationRandomized");
 		registerOpts.push_back("KronNoLoadBalance");
 		registerOpts.push_back("setAffinities");
 		registerOpts.push_back("wftNoAccel");
+		registerOpts.push_back("wftInfinite");
 		registerOpts.push_back("BatchedGemm");
 		registerOpts.push_back("KrylovAbridge");
 		registerOpts.push_back("fixLegacyBugs");
@@ -420,6 +469,12 @@ public:
 			err("BatchedGemm needs -DPLUGIN_SC in Config.make\n");
 #endif
 		}
+
+		bool wftInfinite = (val.find("wftInfinite") != PsimagLite::String::npos);
+		bool wftNoAccel = (val.find("wftNoAccel") != PsimagLite::String::npos);
+		bool twoSite = (val.find("twositedmrg") != PsimagLite::String::npos);
+		if (wftInfinite && wftNoAccel && !twoSite)
+			err("FATAL: wftInfinite with wftNoAccel needs twositedmrg\n");
 	}
 
 	bool isSet(const PsimagLite::String& thisOption) const
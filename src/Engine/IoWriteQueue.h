@@ -0,0 +1,390 @@
+/*
+Copyright (c) 2009-2019, UT-Battelle, LLC
+All rights reserved
+
+[DMRG++, Version 5.]
+[by G.A., Oak Ridge National Laboratory]
+
+UT Battelle Open Source Software License 11242008
+
+OPEN SOURCE LICENSE
+
+Subject to the conditions of this License, each
+contributor to this software hereby grants, free of
+charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), a
+perpetual, worldwide, non-exclusive, no-charge,
+royalty-free, irrevocable copyright license to use, copy,
+modify, merge, publish, distribute, and/or sublicense
+copies of the Software.
+
+1. Redistributions of Software must retain the above
+copyright and license notices, this list of conditions,
+and the following disclaimer.  Changes or modifications
+to, or derivative works of, the Software should be noted
+with comments and the contributor and organization's
+name.
+
+2. Neither the names of UT-Battelle, LLC or the
+Department of Energy nor the names of the Software
+contributors may be used to endorse or promote products
+derived from this software without specific prior written
+permission of UT-Battelle.
+
+3. The software and the end-user documentation included
+with the redistribution, with or without modification,
+must include the following acknowledgment:
+
+"This product includes software produced by UT-Battelle,
+LLC under Contract No. DE-AC05-00OR22725  with the
+Department of Energy."
+
+*********************************************************
+DISCLAIMER
+
+THE SOFTWARE IS SUPPLIED BY THE COPYRIGHT HOLDERS AND
+CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER, CONTRIBUTORS, UNITED STATES GOVERNMENT,
+OR THE UNITED STATES DEPARTMENT OF ENERGY BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+DAMAGE.
+
+NEITHER THE UNITED STATES GOVERNMENT, NOR THE UNITED
+STATES DEPARTMENT OF ENERGY, NOR THE COPYRIGHT OWNER, NOR
+ANY OF THEIR EMPLOYEES, REPRESENTS THAT THE USE OF ANY
+INFORMATION, DATA, APPARATUS, PRODUCT, OR PROCESS
+DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
+
+*********************************************************
+*/
+
+/** \ingroup DMRG */
+/*@{*/
+
+/*! \file IoWriteQueue.h
+ *
+ *  Writes to an output file from a background thread, in order.
+ *  Callers hand over copies (or owned objects), and keep going
+ *  unless the queue is full; drain() waits until all is written.
+ *  With length zero, or if HDF5 is not thread-safe, everything is
+ *  written at once, as before
+ */
+
+#ifndef DMRG_IO_WRITE_QUEUE_H
+#define DMRG_IO_WRITE_QUEUE_H
+#include "Vector.h"
+#include "PsimagLite.h"
+#include "IoThreads.h"
+#include <deque>
+#include <exception>
+#include <iostream>
+#ifdef USE_PTHREADS
+#include <pthread.h>
+#endif
+
+namespace Dmrg {
+
+template<typename IoOutType>
+class IoWriteQueue {
+
+public:
+
+	typedef typename IoOutType::Serializer::WriteMode WriteModeType;
+
+	class Job {
+
+	public:
+
+		virtual ~Job() {}
+
+		virtual void write(IoOutType&) = 0;
+	};
+
+	IoWriteQueue(IoOutType& io, SizeType length)
+	    : io_(io),
+	      length_(length),
+	      busy_(false),
+	      stop_(false)
+	{
+#ifdef USE_PTHREADS
+		if (length_ == 0) return;
+
+		if (!IoThreads::enabled()) {
+			length_ = 0;
+			return;
+		}
+
+		pthread_mutex_init(&mutex_, 0);
+		pthread_cond_init(&changed_, 0);
+		if (pthread_create(&thread_, 0, writerThread, this) == 0) return;
+
+		pthread_cond_destroy(&changed_);
+		pthread_mutex_destroy(&mutex_);
+#endif
+
+		length_ = 0;
+	}
+
+	// errors still pending can only be printed here
+	~IoWriteQueue()
+	{
+		if (length_ == 0) return;
+
+#ifdef USE_PTHREADS
+		pthread_mutex_lock(&mutex_);
+		stop_ = true;
+		pthread_cond_broadcast(&changed_);
+		pthread_mutex_unlock(&mutex_);
+		pthread_join(thread_, 0);
+
+		if (error_ != "")
+			std::cerr<<"IoWriteQueue: "<<error_<<"\n";
+
+		pthread_cond_destroy(&changed_);
+		pthread_mutex_destroy(&mutex_);
+#endif
+	}
+
+	bool inBackground() const { return (length_ > 0); }
+
+	bool isFor(const IoOutType& io) const { return (&io == &io_); }
+
+	void createGroup(PsimagLite::String label)
+	{
+		push(new GroupJob(label));
+	}
+
+	template<typename T>
+	void write(const T& value, PsimagLite::String label)
+	{
+		push(new ValueJob<T>(value, label));
+	}
+
+	template<typename T>
+	void write(const T& value, PsimagLite::String label, WriteModeType mode)
+	{
+		push(new ValueJob<T>(value, label, mode));
+	}
+
+	template<typename T>
+	void writeVectorEntry(const T& value, PsimagLite::String label, SizeType counter)
+	{
+		push(new VectorEntryJob<T>(value, label, counter));
+	}
+
+	// takes ownership of owned, which has write(io, label)
+	template<typename T>
+	void writeObject(T* owned, PsimagLite::String label)
+	{
+		push(new ObjectJob<T>(owned, label));
+	}
+
+	// takes ownership of job; waits while the queue is full
+	void push(Job* job)
+	{
+		if (length_ == 0) {
+			runNow(job);
+			return;
+		}
+
+#ifdef USE_PTHREADS
+		pthread_mutex_lock(&mutex_);
+		while (jobs_.size() >= length_ && error_ == "")
+			pthread_cond_wait(&changed_, &mutex_);
+
+		if (error_ != "") {
+			pthread_mutex_unlock(&mutex_);
+			delete job;
+			reportError();
+		}
+
+		jobs_.push_back(job);
+		pthread_cond_broadcast(&changed_);
+		pthread_mutex_unlock(&mutex_);
+#endif
+	}
+
+	// all that was pushed is in the file when this returns; needed
+	// before using io directly
+	void drain()
+	{
+		if (length_ == 0) return;
+
+#ifdef USE_PTHREADS
+		pthread_mutex_lock(&mutex_);
+		while ((jobs_.size() > 0 || busy_) && error_ == "")
+			pthread_cond_wait(&changed_, &mutex_);
+
+		bool failed = (error_ != "");
+		pthread_mutex_unlock(&mutex_);
+		if (failed) reportError();
+#endif
+	}
+
+private:
+
+	class GroupJob : public Job {
+
+	public:
+
+		GroupJob(PsimagLite::String label) : label_(label) {}
+
+		void write(IoOutType& io) { io.createGroup(label_); }
+
+	private:
+
+		PsimagLite::String label_;
+	};
+
+	template<typename T>
+	class ValueJob : public Job {
+
+	public:
+
+		ValueJob(const T& value, PsimagLite::String label)
+		    : value_(value), label_(label), hasMode_(false), mode_()
+		{}
+
+		ValueJob(const T& value, PsimagLite::String label, WriteModeType mode)
+		    : value_(value), label_(label), hasMode_(true), mode_(mode)
+		{}
+
+		void write(IoOutType& io)
+		{
+			if (hasMode_) io.write(value_, label_, mode_);
+			else io.write(value_, label_);
+		}
+
+	private:
+
+		T value_;
+		PsimagLite::String label_;
+		bool hasMode_;
+		WriteModeType mode_;
+	};
+
+	template<typename T>
+	class VectorEntryJob : public Job {
+
+	public:
+
+		VectorEntryJob(const T& value, PsimagLite::String label, SizeType counter)
+		    : value_(value), label_(label), counter_(counter)
+		{}
+
+		void write(IoOutType& io) { io.writeVectorEntry(value_, label_, counter_); }
+
+	private:
+
+		T value_;
+		PsimagLite::String label_;
+		SizeType counter_;
+	};
+
+	template<typename T>
+	class ObjectJob : public Job {
+
+	public:
+
+		ObjectJob(T* owned, PsimagLite::String label)
+		    : owned_(owned), label_(label)
+		{}
+
+		~ObjectJob() { delete owned_; }
+
+		void write(IoOutType& io) { owned_->write(io, label_); }
+
+	private:
+
+		ObjectJob(const ObjectJob&);
+
+		ObjectJob& operator=(const ObjectJob&);
+
+		T* owned_;
+		PsimagLite::String label_;
+	};
+
+	IoWriteQueue(const IoWriteQueue&);
+
+	IoWriteQueue& operator=(const IoWriteQueue&);
+
+	void runNow(Job* job)
+	{
+		try {
+			job->write(io_);
+		} catch (...) {
+			delete job;
+			throw;
+		}
+
+		delete job;
+	}
+
+	void reportError()
+	{
+		err("IoWriteQueue: writing to " + io_.filename() + " failed: " + error_ + "\n");
+	}
+
+#ifdef USE_PTHREADS
+	// on exit, writes what is left before stopping
+	static void* writerThread(void* arg)
+	{
+		IoWriteQueue* self = static_cast<IoWriteQueue*>(arg);
+		pthread_mutex_lock(&self->mutex_);
+		while (true) {
+			while (self->jobs_.size() == 0 && !self->stop_)
+				pthread_cond_wait(&self->changed_, &self->mutex_);
+
+			if (self->jobs_.size() == 0) break;
+
+			Job* job = self->jobs_.front();
+			self->jobs_.pop_front();
+			self->busy_ = true;
+			pthread_mutex_unlock(&self->mutex_);
+
+			PsimagLite::String error;
+			try {
+				job->write(self->io_);
+			} catch (std::exception& e) {
+				error = e.what();
+			}
+
+			delete job;
+
+			pthread_mutex_lock(&self->mutex_);
+			self->busy_ = false;
+			if (error != "" && self->error_ == "") self->error_ = error;
+			pthread_cond_broadcast(&self->changed_);
+		}
+
+		pthread_mutex_unlock(&self->mutex_);
+		return 0;
+	}
+#endif
+
+	IoOutType& io_;
+	SizeType length_;
+	std::deque<Job*> jobs_;
+	bool busy_;
+	bool stop_;
+	PsimagLite::String error_;
+#ifdef USE_PTHREADS
+	pthread_t thread_;
+	pthread_mutex_t mutex_;
+	pthread_cond_t changed_;
+#endif
+}; // class IoWriteQueue
+} // namespace Dmrg
+
+/*@}*/
+#endif
@@ -0,0 +1,316 @@
+/*
+Copyright (c) 2009-2019, UT-Battelle, LLC
+All rights reserved
+
+[DMRG++, Version 5.]
+[by G.A., Oak Ridge National Laboratory]
+
+UT Battelle Open Source Software License 11242008
+
+OPEN SOURCE LICENSE
+
+Subject to the conditions of this License, each
+contributor to this software hereby grants, free of
+charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), a
+perpetual, worldwide, non-exclusive, no-charge,
+royalty-free, irrevocable copyright license to use, copy,
+modify, merge, publish, distribute, and/or sublicense
+copies of the Software.
+
+1. Redistributions of Software must retain the above
+copyright and license notices, this list of conditions,
+and the following disclaimer.  Changes or modifications
+to, or derivative works of, the Software should be noted
+with comments and the contributor and organization's
+name.
+
+2. Neither the names of UT-Battelle, LLC or the
+Department of Energy nor the names of the Software
+contributors may be used to endorse or promote products
+derived from this software without specific prior written
+permission of UT-Battelle.
+
+3. The software and the end-user documentation included
+with the redistribution, with or without modification,
+must include the following acknowledgment:
+
+"This product includes software produced by UT-Battelle,
+LLC under Contract No. DE-AC05-00OR22725  with the
+Department of Energy."
+
+*********************************************************
+DISCLAIMER
+
+THE SOFTWARE IS SUPPLIED BY THE COPYRIGHT HOLDERS AND
+CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER, CONTRIBUTORS, UNITED STATES GOVERNMENT,
+OR THE UNITED STATES DEPARTMENT OF ENERGY BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+DAMAGE.
+
+NEITHER THE UNITED STATES GOVERNMENT, NOR THE UNITED
+STATES DEPARTMENT OF ENERGY, NOR THE COPYRIGHT OWNER, NOR
+ANY OF THEIR EMPLOYEES, REPRESENTS THAT THE USE OF ANY
+INFORMATION, DATA, APPARATUS, PRODUCT, OR PROCESS
+DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
+
+*********************************************************
+
+*/
+
+/** \ingroup DMRG */
+/*@{*/
+
+/*! \file LanczosThickRestart.h
+ *
+ *  Thick-restart Lanczos for the lowest eigenpair, keeping at most
+ *  maxVectors Krylov vectors (plus one work vector) in memory.
+ *  When the cap is reached, the lowest Ritz vectors are kept, together with
+ *  the normalized residual, and the iteration continues from there
+ *  (K. Wu and H. Simon, SIAM J. Matrix Anal. Appl. 22, 602 (2000)).
+ *  Convergence is as in PsimagLite's Lanczos: the lowest Ritz value
+ *  changes by less than eps from one step to the next
+ *
+ */
+#ifndef LANCZOS_THICK_RESTART_H
+#define LANCZOS_THICK_RESTART_H
+
+#include "Matrix.h"
+#include "Vector.h"
+#include "ProgressIndicator.h"
+#include "Random48.h"
+#include <algorithm>
+#include <cmath>
+
+namespace Dmrg {
+
+template<typename MatrixType, typename VectorType>
+class LanczosThickRestart {
+
+	typedef typename VectorType::value_type FieldType;
+	typedef typename PsimagLite::Real<FieldType>::Type RealType;
+	typedef typename PsimagLite::Vector<VectorType>::Type VectorVectorType;
+	typedef typename PsimagLite::Vector<RealType>::Type VectorRealType;
+	typedef PsimagLite::Matrix<FieldType> MatrixFieldType;
+
+public:
+
+	LanczosThickRestart(const MatrixType& mat,
+	                    SizeType maxVectors,
+	                    SizeType maxSteps,
+	                    RealType eps)
+	    : progress_("LanczosThickRestart"),
+	      mat_(mat),
+	      maxVectors_((maxVectors < 2) ? 2 : maxVectors),
+	      maxSteps_(maxSteps),
+	      eps_(eps),
+	      steps_(0),
+	      restarts_(0)
+	{}
+
+	//! Lowest eigenvalue in energy and its eigenvector in x, starting from guess
+	void computeGroundState(RealType& energy,
+	                        VectorType& x,
+	                        const VectorType& guess)
+	{
+		SizeType n = guess.size();
+		x.resize(n);
+		if (n == 0) return;
+
+		SizeType maxVectors = (maxVectors_ > n) ? n : maxVectors_;
+		SizeType kept = maxVectors/2;
+		if (kept == 0) kept = 1;
+
+		VectorVectorType v(maxVectors);
+		v[0] = guess;
+		if (normalize(v[0]) < 1e-12) randomVector(v[0]);
+
+		MatrixFieldType t(maxVectors, maxVectors);
+		MatrixFieldType y;
+		VectorRealType eigs;
+		VectorType w(n);
+		RealType residual = 0;
+		RealType previousEnergy = 0;
+		bool converged = false;
+		SizeType current = 0; // index of the vector about to be multiplied
+		steps_ = restarts_ = 0;
+
+		while (true) {
+			// H v_current, projected out of the stored basis (twice)
+			std::fill(w.begin(), w.end(), 0.0);
+			mat_.matrixVectorProduct(w, v[current]);
+			++steps_;
+
+			for (SizeType i = 0; i <= current; ++i)
+				t(i, current) = project(w, v[i]);
+			for (SizeType i = 0; i <= current; ++i)
+				t(i, current) += project(w, v[i]);
+			for (SizeType i = 0; i < current; ++i)
+				t(current, i) = PsimagLite::conj(t(i, current));
+			t(current, current) = PsimagLite::real(t(current, current));
+
+			RealType beta = PsimagLite::norm(w);
+			SizeType m = current + 1;
+			ritz(y, eigs, t, m);
+			energy = eigs[0];
+			const FieldType last = y(m - 1, 0);
+			residual = beta*sqrt(PsimagLite::real(last*PsimagLite::conj(last)));
+
+			// the Ritz value does not move across a restart, so the
+			// comparison holds there too
+			converged = ((steps_ > 1 && fabs(energy - previousEnergy) < eps_) ||
+			             beta < 1e-12 ||
+			             m == n);
+			previousEnergy = energy;
+			if (converged || steps_ >= maxSteps_) {
+				ritzVector(x, v, y, m);
+				break;
+			}
+
+			if (m < maxVectors) {
+				v[m] = w;
+				scale(v[m], 1.0/beta);
+				current = m;
+				continue;
+			}
+
+			// restart: keep the lowest Ritz vectors, then the residual
+			restart(v, y, m, kept);
+			for (SizeType i = 0; i < maxVectors; ++i)
+				for (SizeType j = 0; j < maxVectors; ++j)
+					t(i, j) = 0.0;
+			for (SizeType i = 0; i < kept; ++i)
+				t(i, i) = eigs[i];
+
+			v[kept] = w;
+			scale(v[kept], 1.0/beta);
+			current = kept;
+			++restarts_;
+		}
+
+		PsimagLite::OstringStream msg;
+		msg<<"Found lowest eigenvalue= "<<energy<<" after "<<steps_<<" steps and ";
+		msg<<restarts_<<" restarts (maxVectors= "<<maxVectors<<") residual= "<<residual;
+		progress_.printline(msg,std::cout);
+
+		if (converged) return;
+
+		PsimagLite::OstringStream msg2;
+		msg2<<"WARNING: energy not converged after "<<maxSteps_<<" steps";
+		progress_.printline(msg2,std::cout);
+	}
+
+	SizeType steps() const { return steps_; }
+
+private:
+
+	// w -= <v|w> v, returns <v|w>
+	FieldType project(VectorType& w, const VectorType& v) const
+	{
+		FieldType sum = 0;
+		SizeType n = w.size();
+		for (SizeType i = 0; i < n; ++i)
+			sum += PsimagLite::conj(v[i])*w[i];
+		for (SizeType i = 0; i < n; ++i)
+			w[i] -= sum*v[i];
+		return sum;
+	}
+
+	RealType normalize(VectorType& v) const
+	{
+		RealType norma = PsimagLite::norm(v);
+		if (norma < 1e-12) return norma;
+		scale(v, 1.0/norma);
+		return norma;
+	}
+
+	void scale(VectorType& v, RealType factor) const
+	{
+		SizeType n = v.size();
+		for (SizeType i = 0; i < n; ++i)
+			v[i] *= factor;
+	}
+
+	void randomVector(VectorType& v) const
+	{
+		PsimagLite::Random48<RealType> rng(3433117);
+		SizeType n = v.size();
+		for (SizeType i = 0; i < n; ++i)
+			v[i] = rng() - 0.5;
+		normalize(v);
+	}
+
+	// eigenpairs of the leading m x m block of t, eigenvectors in columns of y
+	static void ritz(MatrixFieldType& y,
+	                 VectorRealType& eigs,
+	                 const MatrixFieldType& t,
+	                 SizeType m)
+	{
+		y.clear();
+		y.resize(m, m);
+		eigs.resize(m);
+		for (SizeType i = 0; i < m; ++i)
+			for (SizeType j = 0; j < m; ++j)
+				y(i, j) = t(i, j);
+		PsimagLite::diag(y, eigs, 'V');
+	}
+
+	static void ritzVector(VectorType& x,
+	                       const VectorVectorType& v,
+	                       const MatrixFieldType& y,
+	                       SizeType m)
+	{
+		SizeType n = x.size();
+		std::fill(x.begin(), x.end(), 0.0);
+		for (SizeType j = 0; j < m; ++j) {
+			const FieldType c = y(j, 0);
+			const VectorType& vj = v[j];
+			for (SizeType i = 0; i < n; ++i)
+				x[i] += c*vj[i];
+		}
+	}
+
+	// v[i] <-- sum_j v[j] y(j,i) for i < kept, in place, one row at a time
+	static void restart(VectorVectorType& v,
+	                    const MatrixFieldType& y,
+	                    SizeType m,
+	                    SizeType kept)
+	{
+		SizeType n = v[0].size();
+		VectorType row(m);
+		for (SizeType p = 0; p < n; ++p) {
+			for (SizeType j = 0; j < m; ++j)
+				row[j] = v[j][p];
+			for (SizeType i = 0; i < kept; ++i) {
+				FieldType sum = 0;
+				for (SizeType j = 0; j < m; ++j)
+					sum += row[j]*y(j, i);
+				v[i][p] = sum;
+			}
+		}
+	}
+
+	PsimagLite::ProgressIndicator progress_;
+	const MatrixType& mat_;
+	SizeType maxVectors_;
+	SizeType maxSteps_;
+	RealType eps_;
+	SizeType steps_;
+	SizeType restarts_;
+}; // class LanczosThickRestart
+
+} // namespace Dmrg
+
+/*@}*/
+#endif // LANCZOS_THICK_RESTART_H
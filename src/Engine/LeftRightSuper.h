@@ -241,9 +241,19 @@ public:
 
 	const BasisWithOperatorsType& right() const { return *right_; }
 
-	BasisWithOperatorsType& leftNonConst()  { return *left_; }
+	BasisWithOperatorsType& leftNonConst()
+	{
+		if (refCounter_>0)
+			throw PsimagLite::RuntimeError("LeftRightSuper::leftNonConst(): not the owner\n");
+		return *left_;
+	}
 
-	BasisWithOperatorsType& rightNonConst() { return *right_; }
+	BasisWithOperatorsType& rightNonConst()
+	{
+		if (refCounter_>0)
+			throw PsimagLite::RuntimeError("LeftRightSuper::rightNonConst(): not the owner\n");
+		return *right_;
+	}
 
 	const SuperBlockType& super() const
 	{
@@ -284,6 +294,21 @@ public:
 		right_->read(io, prefix + "/" + nameEnviron);
 	}
 
+	// deep copy of what write(io, prefix, option, ...) saves; with
+	// SAVE_PARTIAL the operators of left and right are not copied
+	void copyForWrite(const ThisType& lrs, SizeType option)
+	{
+		if (option != SAVE_PARTIAL) {
+			deepCopy(lrs);
+			return;
+		}
+
+		left_->copyForPartialWrite(*lrs.left_);
+		right_->copyForPartialWrite(*lrs.right_);
+		*super_=*lrs.super_;
+		if (refCounter_>0) refCounter_--;
+	}
+
 private:
 
 	LeftRightSuper(ThisType& rls);
@@ -83,6 +83,7 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 #include "GenIjPatch.h"
 #include "CrsMatrix.h"
 #include "../KronUtil/MatrixDenseOrSparse.h"
+#include <algorithm>
 
 namespace Dmrg {
 
@@ -112,36 +113,67 @@ public:
 		            patchNew.lrs().left() : patchNew.lrs().right();
 		SizeType npatchOld = patchOld(leftOrRight).size();
 		SizeType npatchNew = patchNew(leftOrRight).size();
-		for (SizeType jpatch=0; jpatch < npatchOld; ++jpatch) {
+
+		// column patches sorted by their first column, so that
+		// each nonzero is routed to its patch with a binary search
+		// (empty patches never own a column and are left out)
+		VectorPairSizeType colStarts;
+		VectorSizeType colOffset(npatchOld, 0);
+		VectorSizeType colTotal(npatchOld, 0);
+		for (SizeType jpatch = 0; jpatch < npatchOld; ++jpatch) {
 			SizeType jgroup = patchOld(leftOrRight)[jpatch];
-			SizeType j1 = basisOld.partition(jgroup);
-			SizeType j2 = basisOld.partition(jgroup+1);
-			for (SizeType ipatch=0; ipatch < npatchNew; ++ipatch) {
-				SizeType igroup = patchNew(leftOrRight)[ipatch];
-				SizeType i1 = basisNew.partition(igroup);
-				SizeType i2 = basisNew.partition(igroup+1);
-
-				SparseMatrixType tmp(i2-i1,  j2-j1);
-				SizeType counter = 0;
-				for (SizeType ii = i1; ii < i2; ++ii) {
-					tmp.setRow(ii - i1, counter);
-					SizeType start = sparse.getRowPtr(ii);
-					SizeType end = sparse.getRowPtr(ii+1);
-					for (SizeType k = start; k < end; ++k) {
-						int col = sparse.getCol(k)-j1;
-						if (col < 0) continue;
-						if (SizeType(col)>=j2-j1) continue;
-						tmp.pushValue(sparse.getValue(k));
-						tmp.pushCol(col);
-						++counter;
-					}
-				}
+			colOffset[jpatch] = basisOld.partition(jgroup);
+			colTotal[jpatch] = basisOld.partition(jgroup + 1) - colOffset[jpatch];
+			if (colTotal[jpatch] == 0) continue;
+			colStarts.push_back(PairSizeType(colOffset[jpatch], jpatch));
+		}
+
+		std::sort(colStarts.begin(), colStarts.end());
+
+		typename PsimagLite::Vector<SparseMatrixType*>::Type tmp(npatchOld, 0);
+		VectorSizeType counter(npatchOld, 0);
 
-				tmp.setRow(i2-i1,counter);
-				tmp.checkValidity();
-				data_(ipatch,jpatch) = (useLowerPart && (ipatch < jpatch)) ?
+		// one pass over the rows of each row patch fills all its column patches
+		for (SizeType ipatch = 0; ipatch < npatchNew; ++ipatch) {
+			SizeType igroup = patchNew(leftOrRight)[ipatch];
+			SizeType i1 = basisNew.partition(igroup);
+			SizeType i2 = basisNew.partition(igroup+1);
+
+			for (SizeType jpatch = 0; jpatch < npatchOld; ++jpatch) {
+				counter[jpatch] = 0;
+				tmp[jpatch] = (useLowerPart && (ipatch < jpatch)) ?
 				            0 :
-				            new MatrixDenseOrSparseType(tmp, threshold);
+				            new SparseMatrixType(i2 - i1, colTotal[jpatch]);
+			}
+
+			for (SizeType ii = i1; ii < i2; ++ii) {
+				for (SizeType jpatch = 0; jpatch < npatchOld; ++jpatch)
+					if (tmp[jpatch]) tmp[jpatch]->setRow(ii - i1, counter[jpatch]);
+
+				SizeType start = sparse.getRowPtr(ii);
+				SizeType end = sparse.getRowPtr(ii+1);
+				for (SizeType k = start; k < end; ++k) {
+					SizeType col = sparse.getCol(k);
+					int jpatch = findPatch(colStarts, colOffset, colTotal, col);
+					if (jpatch < 0 || tmp[jpatch] == 0) continue;
+					tmp[jpatch]->pushValue(sparse.getValue(k));
+					tmp[jpatch]->pushCol(col - colOffset[jpatch]);
+					++counter[jpatch];
+				}
+			}
+
+			for (SizeType jpatch = 0; jpatch < npatchOld; ++jpatch) {
+				if (tmp[jpatch] == 0) {
+					data_(ipatch, jpatch) = 0;
+					continue;
+				}
+
+				tmp[jpatch]->setRow(i2 - i1, counter[jpatch]);
+				tmp[jpatch]->checkValidity();
+				data_(ipatch, jpatch) = new MatrixDenseOrSparseType(*tmp[jpatch],
+				                                                    threshold);
+				delete tmp[jpatch];
+				tmp[jpatch] = 0;
 			}
 		}
 	}
@@ -162,6 +194,25 @@ public:
 
 private:
 
+	typedef std::pair<SizeType, SizeType> PairSizeType;
+	typedef typename PsimagLite::Vector<PairSizeType>::Type VectorPairSizeType;
+
+	static int findPatch(const VectorPairSizeType& colStarts,
+	                     const VectorSizeType& colOffset,
+	                     const VectorSizeType& colTotal,
+	                     SizeType col)
+	{
+		typename VectorPairSizeType::const_iterator it =
+		        std::upper_bound(colStarts.begin(),
+		                         colStarts.end(),
+		                         PairSizeType(col, colOffset.size()));
+		if (it == colStarts.begin()) return -1;
+		--it;
+		SizeType jpatch = it->second;
+		if (col - colOffset[jpatch] >= colTotal[jpatch]) return -1;
+		return jpatch;
+	}
+
 	ArrayOfMatStruct(const ArrayOfMatStruct&);
 
 	ArrayOfMatStruct& operator=(const ArrayOfMatStruct&);
@@ -82,6 +82,7 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 #include "Vector.h"
 #include "Link.h"
 #include "ProgressIndicator.h"
+#include "ParallelWeights.h"
 
 namespace Dmrg {
 
@@ -279,7 +280,7 @@ protected:
 		SizeType npatches = patch(what, GenIjPatchType::LEFT).size();
 		assert(npatches > 0);
 		SizeType ip = 0;
-		VectorSizeType weights(npatches, 0);
+		ParallelWeights::VectorLongType weights(npatches, 0);
 		const BasisType& left = lrs(what).left();
 		const BasisType& right = lrs(what).right();
 
@@ -298,7 +299,8 @@ protected:
 			assert(1 <= sizeLeft);
 			assert(1 <= sizeRight);
 
-			weights[ipatch] = sizeLeft * sizeRight * (sizeLeft + sizeRight);
+			weights[ipatch] = static_cast<long unsigned int>(sizeLeft)*sizeRight*
+			        (sizeLeft + sizeRight);
 
 			ip += sizeLeft * sizeRight;
 		}
@@ -306,7 +308,7 @@ protected:
 		vstart[npatches] = ip;
 
 		if (what == NEW)
-			setAndFixWeights(weights);
+			ParallelWeights::fromCosts(weightsOfPatches_, weights);
 	}
 
 	// -------------------
@@ -363,19 +365,6 @@ protected:
 
 private:
 
-	void setAndFixWeights(const VectorSizeType& weights)
-	{
-		long unsigned int max = *(std::max_element(weights.begin(), weights.end()));
-		max >>= 31;
-		SizeType bits = 1 + PsimagLite::log2Integer(max);
-		SizeType npatches = weights.size();
-		weightsOfPatches_.resize(npatches);
-		for (SizeType ipatch=0; ipatch < npatches; ++ipatch) {
-			long unsigned int tmp = (weights[ipatch] >> bits);
-			weightsOfPatches_[ipatch] = (max == 0) ? weights[ipatch] : tmp;
-		}
-	}
-
 	static SizeType sizeInternal(const GenIjPatchType& ijpatches,
 	                             SizeType m)
 	{
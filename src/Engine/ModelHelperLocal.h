@@ -74,6 +74,7 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 #include "Link.h"
 #include "Concurrency.h"
 #include "Vector.h"
+#include <limits>
 
 /** \ingroup DMRG */
 /*@{*/
@@ -83,6 +84,11 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
  *  A class to contain state information about the Hamiltonian
  *  to help with the calculation of x+=Hy
  *
+ *  The width of indices is chosen when compiling, not per run. Offsets
+ *  into the superblock are SizeType, which holds 2^31 states or more only
+ *  if compiled with -DUSE_LONG. Indices inside one symmetry sector are int
+ *  in either build, so a sector of 2^31 states or more is an error.
+ *
  */
 
 namespace Dmrg {
@@ -199,7 +205,7 @@ public:
 		}
 
 		int m = m_;
-		int offset = lrs_.super().partition(m);
+		SizeType offset = lrs_.super().partition(m);
 		int total = lrs_.super().partition(m+1) - offset;
 		int counter=0;
 		matrixBlock.resize(total,total);
@@ -258,7 +264,7 @@ public:
 
 		//! work only on partition m
 		int m = m_;
-		int offset = lrs_.super().partition(m);
+		SizeType offset = lrs_.super().partition(m);
 		int total = lrs_.super().partition(m+1) - offset;
 
 		for (int i=0;i<total;++i) {
@@ -309,7 +315,7 @@ public:
 	                            const VectorSparseElementType& y) const
 	{
 		int m = m_;
-		int offset = lrs_.super().partition(m);
+		SizeType offset = lrs_.super().partition(m);
 		int i,k,alphaPrime;
 		int bs = lrs_.super().partition(m+1)-offset;
 		const SparseMatrixType& hamiltonian = lrs_.left().hamiltonian();
@@ -342,7 +348,7 @@ public:
 	                             const VectorSparseElementType& y) const
 	{
 		int m = m_;
-		int offset = lrs_.super().partition(m);
+		SizeType offset = lrs_.super().partition(m);
 		int i,k;
 		int bs = lrs_.super().partition(m+1)-offset;
 		const SparseMatrixType& hamiltonian = lrs_.right().hamiltonian();
@@ -432,15 +438,24 @@ private:
 	{
 		SizeType ns=lrs_.left().size();
 		SizeType ne=lrs_.right().size();
-		int offset = lrs_.super().partition(m_);
-		int total = lrs_.super().partition(m_+1) - offset;
+		SizeType offset = lrs_.super().partition(m_);
+		SizeType total = lrs_.super().partition(m_+1) - offset;
+
+		// offsets into the superblock may need all bits of SizeType, but
+		// indices inside one symmetry sector are kept as int
+		if (total > static_cast<SizeType>(std::numeric_limits<int>::max())) {
+			PsimagLite::String msg("ModelHelperLocal: symmetry sector of ");
+			msg += ttos(total) + " states is too large for int indices;";
+			msg += " this limit does not depend on -DUSE_LONG\n";
+			err(msg);
+		}
 
 		typename PsimagLite::Vector<int>::Type  tmpBuffer(ne);
 		for (SizeType alphaPrime=0;alphaPrime<ns;alphaPrime++) {
 			for (SizeType betaPrime=0;betaPrime<ne;betaPrime++) {
-				tmpBuffer[betaPrime] = lrs_.super().
-				        permutationInverse(alphaPrime + betaPrime*ns) -offset;
-				if (tmpBuffer[betaPrime]>=total) tmpBuffer[betaPrime]= -1;
+				SizeType j = lrs_.super().permutationInverse(alphaPrime + betaPrime*ns);
+				tmpBuffer[betaPrime] = (j >= offset && j - offset < total) ?
+				            static_cast<int>(j - offset) : -1;
 			}
 			buffer_[alphaPrime]=tmpBuffer;
 		}
@@ -449,7 +464,7 @@ private:
 	void createAlphaAndBeta()
 	{
 		SizeType ns=lrs_.left().size();
-		int offset = lrs_.super().partition(m_);
+		SizeType offset = lrs_.super().partition(m_);
 		int total = lrs_.super().partition(m_+1) - offset;
 
 		PackIndicesType pack(ns);
@@ -142,7 +142,8 @@ public:
 	              model.params().nthreads,
 	              hasTimeEvolution,
 	              verbose,
-	              (model.params().options.find("fixLegacyBugs") == PsimagLite::String::npos)),
+	              (model.params().options.find("fixLegacyBugs") == PsimagLite::String::npos),
+	              model.params().observerCacheMegabytes),
 	      onepoint_(helper_),
 	      skeleton_(helper_,model,verbose),
 	      twopoint_(helper_,skeleton_),
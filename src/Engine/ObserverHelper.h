@@ -75,6 +75,9 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
  *
  *  A class to read and serve precomputed data to the observer
  *
+ *  Serializer entries are read when first needed, and kept in memory
+ *  up to a budget, evicting the least recently used ones; the entry
+ *  after the one just pointed to is read in the background
  */
 #ifndef PRECOMPUTED_H
 #define PRECOMPUTED_H
@@ -84,6 +87,11 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 #include "DmrgSerializer.h"
 #include "VectorWithOffsets.h" // to include norm
 #include "VectorWithOffset.h" // to include norm
+#include "IoThreads.h"
+#include <exception>
+#ifdef USE_PTHREADS
+#include <pthread.h>
+#endif
 
 namespace Dmrg {
 template<typename IoInputType_,
@@ -110,6 +118,7 @@ public:
 	typedef DmrgSerializer<LeftRightSuperType,VectorWithOffsetType> DmrgSerializerType;
 	typedef typename DmrgSerializerType::FermionSignType FermionSignType;
 	typedef PsimagLite::Vector<SizeType>::Type VectorSizeType;
+	typedef PsimagLite::Vector<long unsigned int>::Type VectorLongType;
 	typedef PsimagLite::Vector<short int>::Type VectorShortIntType;
 
 	enum {LEFT_BRAKET=0,RIGHT_BRAKET=1};
@@ -121,16 +130,30 @@ public:
 	               SizeType numberOfPthreads,
 	               bool hasTimeEvolution,
 	               bool verbose,
-	               bool withLegacyBugs)
+	               bool withLegacyBugs,
+	               SizeType cacheMegabytes)
 	    : io_(io),
 	      currentPos_(numberOfPthreads),
+	      previousPos_(numberOfPthreads),
 	      verbose_(verbose),
 	      withLegacyBugs_(withLegacyBugs),
 	      bracket_(2,0),
 	      noMoreData_(false),
 	      dSsize_(0),
-	      timeSsize_(0)
+	      timeSsize_(0),
+	      budget_(static_cast<long unsigned int>(cacheMegabytes)*1024*1024),
+	      residentBytes_(0),
+	      clock_(0),
+	      prefetchPos_(0),
+	      prefetchRunning_(false),
+	      prefetchDone_(false),
+	      prefetchEnabled_(IoThreads::enabled())
 	{
+#ifdef USE_PTHREADS
+		pthread_mutex_init(&cacheMutex_, 0);
+		pthread_mutex_init(&ioMutex_, 0);
+#endif
+
 		VectorSizeType electronsOneSite;
 		io_.read(electronsOneSite, "ElectronsOneSite");
 		SizeType n = electronsOneSite.size();
@@ -149,6 +172,10 @@ public:
 
 	~ObserverHelper()
 	{
+#ifdef USE_PTHREADS
+		if (prefetchRunning_) pthread_join(prefetchThread_, 0);
+#endif
+
 		for (SizeType i=0;i<dSsize_;i++) {
 			DmrgSerializerType* p = dSerializerV_[i];
 			delete p;
@@ -156,6 +183,11 @@ public:
 
 		dSerializerV_.clear();
 		dSsize_ = 0;
+
+#ifdef USE_PTHREADS
+		pthread_mutex_destroy(&cacheMutex_);
+		pthread_mutex_destroy(&ioMutex_);
+#endif
 	}
 
 	bool endOfData() const { return noMoreData_; }
@@ -163,7 +195,11 @@ public:
 	void setPointer(SizeType threadId, SizeType pos)
 	{
 		assert(threadId<currentPos_.size());
+		lockCache();
+		previousPos_[threadId]=currentPos_[threadId];
 		currentPos_[threadId]=pos;
+		unlockCache();
+		prefetchNext(threadId);
 	}
 
 	SizeType getPointer(SizeType threadId) const
@@ -181,19 +217,19 @@ public:
 	void transform(SparseMatrixType& ret,const SparseMatrixType& O2,size_t threadId) const
 	{
 		assert(checkPos(threadId));
-		return dSerializerV_[currentPos_[threadId]]->transform(ret,O2);
+		return serializer(threadId).transform(ret,O2);
 	}
 
 	SizeType cols(SizeType threadId) const
 	{
 		assert(checkPos(threadId));
-		return dSerializerV_[currentPos_[threadId]]->cols();
+		return serializer(threadId).cols();
 	}
 
 	SizeType rows(SizeType threadId) const
 	{
 		assert(checkPos(threadId));
-		return dSerializerV_[currentPos_[threadId]]->rows();
+		return serializer(threadId).rows();
 	}
 
 	short int signsOneSite(SizeType site) const
@@ -205,30 +241,30 @@ public:
 	const FermionSignType& fermionicSignLeft(SizeType threadId) const
 	{
 		assert(checkPos(threadId));
-		return dSerializerV_[currentPos_[threadId]]->fermionicSignLeft();
+		return serializer(threadId).fermionicSignLeft();
 	}
 
 	const FermionSignType& fermionicSignRight(SizeType threadId) const
 	{
 		assert(checkPos(threadId));
-		return dSerializerV_[currentPos_[threadId]]->fermionicSignRight();
+		return serializer(threadId).fermionicSignRight();
 	}
 
 	const LeftRightSuperType& leftRightSuper(SizeType threadId) const
 	{
-		return dSerializerV_[currentPos_[threadId]]->leftRightSuper();
+		return serializer(threadId).leftRightSuper();
 	}
 
 	ProgramGlobals::DirectionEnum direction(SizeType threadId) const
 	{
 		assert(checkPos(threadId));
-		return dSerializerV_[currentPos_[threadId]]->direction();
+		return serializer(threadId).direction();
 	}
 
 	const VectorWithOffsetType& wavefunction(SizeType threadId) const
 	{
 		assert(checkPos(threadId));
-		return dSerializerV_[currentPos_[threadId]]->wavefunction();
+		return serializer(threadId).wavefunction();
 	}
 
 	RealType time(SizeType threadId) const
@@ -242,7 +278,7 @@ public:
 	{
 		assert(checkPos(threadId));
 		return  (timeSsize_==0) ?
-		            dSerializerV_[currentPos_[threadId]]->site()
+		            serializer(threadId).site()
 		        : timeSerializerV_[currentPos_[threadId]].site();
 		}
 
@@ -296,6 +332,7 @@ public:
 
 private:
 
+	// serializers are only counted here; see serializerAt()
 	bool init(bool hasTimeEvolution,
 	          SizeType nf,
 	          SaveEnum saveOrNot)
@@ -303,32 +340,188 @@ private:
 		PsimagLite::String prefix = "Serializer";
 		SizeType total = 0;
 		io_.read(total, prefix + "/Size");
-		for (SizeType i = 0; i < total; ++i) {
-			if (nf > 0 && i == nf) break;
+		if (nf > 0 && nf < total) total = nf;
 
-			DmrgSerializerType* dSerializer = new DmrgSerializerType(io_,
-			                                                         prefix + "/" + ttos(i),
-			                                                         false,
-			                                                         true);
-			if (saveOrNot == SAVE_YES)
-				dSerializerV_.push_back(dSerializer);
-			else
-				delete dSerializer;
-			if (hasTimeEvolution) {
-				TimeSerializerType ts(io_, ""); // FIXME
-				if (saveOrNot == SAVE_YES)
-					timeSerializerV_.push_back(ts);
-			}
+		if (saveOrNot == SAVE_YES) {
+			dSerializerV_.resize(total, 0);
+			bytes_.resize(total, 0);
+			lastUse_.resize(total, 0);
+		}
 
-			std::cerr<<__FILE__<<" read "<<i<<" out of "<<total<<"\n";
+		for (SizeType i = 0; i < total; ++i) {
+			if (!hasTimeEvolution) break;
+			TimeSerializerType ts(io_, ""); // FIXME
+			if (saveOrNot == SAVE_YES)
+				timeSerializerV_.push_back(ts);
 		}
 
+		std::cerr<<__FILE__<<" found "<<total<<" serializer entries\n";
+
 		dSsize_ = dSerializerV_.size();
 		timeSsize_ = timeSerializerV_.size();
 		noMoreData_ = true;
 		return (dSsize_ > 0);
 	}
 
+	const DmrgSerializerType& serializer(SizeType threadId) const
+	{
+		assert(checkPos(threadId));
+		return serializerAt(currentPos_[threadId]);
+	}
+
+	// an entry a thread points to, or pointed to last, is never evicted,
+	// so the reference stays valid while the thread uses it
+	const DmrgSerializerType& serializerAt(SizeType pos) const
+	{
+		assert(pos < dSsize_);
+		lockCache();
+		DmrgSerializerType* p = dSerializerV_[pos];
+		if (p) {
+			lastUse_[pos] = ++clock_;
+			unlockCache();
+			return *p;
+		}
+
+		unlockCache();
+
+		DmrgSerializerType* loaded = load(pos);
+
+		lockCache();
+		insert(pos, loaded);
+		p = dSerializerV_[pos];
+		unlockCache();
+		return *p;
+	}
+
+	DmrgSerializerType* load(SizeType pos) const
+	{
+		lockIo();
+		DmrgSerializerType* p = 0;
+		try {
+			p = new DmrgSerializerType(io_, "Serializer/" + ttos(pos), false, true);
+		} catch (...) {
+			unlockIo();
+			throw;
+		}
+
+		unlockIo();
+		if (verbose_)
+			std::cerr<<__FILE__<<" read "<<pos<<" out of "<<dSsize_<<"\n";
+		return p;
+	}
+
+	// with the cache locked; the entry may have been read meanwhile
+	void insert(SizeType pos, DmrgSerializerType* loaded) const
+	{
+		if (dSerializerV_[pos]) {
+			delete loaded;
+		} else {
+			dSerializerV_[pos] = loaded;
+			bytes_[pos] = loaded->memory();
+			residentBytes_ += bytes_[pos];
+		}
+
+		lastUse_[pos] = ++clock_;
+		evict();
+	}
+
+	// with the cache locked; budget_ == 0 means no limit
+	void evict() const
+	{
+		while (budget_ > 0 && residentBytes_ > budget_) {
+			SizeType victim = dSsize_;
+			for (SizeType i = 0; i < dSsize_; ++i) {
+				if (!dSerializerV_[i] || isPinned(i)) continue;
+				if (victim == dSsize_ || lastUse_[i] < lastUse_[victim]) victim = i;
+			}
+
+			if (victim == dSsize_) return;
+
+			residentBytes_ -= bytes_[victim];
+			delete dSerializerV_[victim];
+			dSerializerV_[victim] = 0;
+		}
+	}
+
+	bool isPinned(SizeType pos) const
+	{
+		for (SizeType i = 0; i < currentPos_.size(); ++i)
+			if (currentPos_[i] == pos || previousPos_[i] == pos) return true;
+
+		return false;
+	}
+
+	// the correlation loops move one site at a time; the entry after
+	// the current one, in the direction of the last move, is read in
+	// the background, one at a time
+	void prefetchNext(SizeType threadId)
+	{
+#ifdef USE_PTHREADS
+		SizeType pos = currentPos_[threadId];
+		bool backwards = (pos > 0 && previousPos_[threadId] == pos + 1);
+		SizeType next = (backwards) ? pos - 1 : pos + 1;
+		if (next >= dSsize_ || !prefetchEnabled_) return;
+
+		lockCache();
+		if ((prefetchRunning_ && !prefetchDone_) || dSerializerV_[next]) {
+			unlockCache();
+			return;
+		}
+
+		if (prefetchRunning_) pthread_join(prefetchThread_, 0);
+
+		prefetchPos_ = next;
+		prefetchDone_ = false;
+		prefetchRunning_ = (pthread_create(&prefetchThread_, 0, prefetchThread, this) == 0);
+		unlockCache();
+#endif
+	}
+
+	// a failed read is reported when the entry is needed
+	static void* prefetchThread(void* arg)
+	{
+		ObserverHelper* self = static_cast<ObserverHelper*>(arg);
+		DmrgSerializerType* loaded = 0;
+		try {
+			loaded = self->load(self->prefetchPos_);
+		} catch (std::exception&) {}
+
+		self->lockCache();
+		if (loaded) self->insert(self->prefetchPos_, loaded);
+		self->prefetchDone_ = true;
+		self->unlockCache();
+		return 0;
+	}
+
+	void lockCache() const
+	{
+#ifdef USE_PTHREADS
+		pthread_mutex_lock(&cacheMutex_);
+#endif
+	}
+
+	void unlockCache() const
+	{
+#ifdef USE_PTHREADS
+		pthread_mutex_unlock(&cacheMutex_);
+#endif
+	}
+
+	// reads from io_ one at a time
+	void lockIo() const
+	{
+#ifdef USE_PTHREADS
+		pthread_mutex_lock(&ioMutex_);
+#endif
+	}
+
+	void unlockIo() const
+	{
+#ifdef USE_PTHREADS
+		pthread_mutex_unlock(&ioMutex_);
+#endif
+	}
+
 	bool checkPos(SizeType threadId) const
 	{
 		if (threadId>=currentPos_.size())
@@ -381,9 +574,11 @@ private:
 	}
 
 	IoInputType& io_;
-	typename PsimagLite::Vector<DmrgSerializerType*>::Type dSerializerV_;
+	// zero for entries not in memory
+	mutable typename PsimagLite::Vector<DmrgSerializerType*>::Type dSerializerV_;
 	typename PsimagLite::Vector<TimeSerializerType>::Type timeSerializerV_;
 	VectorSizeType currentPos_; // it's a vector: one per pthread
+	VectorSizeType previousPos_;
 	bool verbose_;
 	bool withLegacyBugs_;
 	VectorSizeType bracket_;
@@ -391,6 +586,20 @@ private:
 	SizeType dSsize_;
 	SizeType timeSsize_;
 	VectorShortIntType signsOneSite_;
+	long unsigned int budget_;
+	mutable VectorLongType bytes_;
+	mutable VectorSizeType lastUse_;
+	mutable long unsigned int residentBytes_;
+	mutable SizeType clock_;
+	SizeType prefetchPos_;
+	bool prefetchRunning_;
+	bool prefetchDone_;
+	bool prefetchEnabled_;
+#ifdef USE_PTHREADS
+	pthread_t prefetchThread_;
+	mutable pthread_mutex_t cacheMutex_;
+	mutable pthread_mutex_t ioMutex_;
+#endif
 };  //ObserverHelper
 } // namespace Dmrg
 
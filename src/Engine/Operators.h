@@ -81,10 +81,13 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 
 #include "ReducedOperators.h"
 #include <cassert>
+#include <algorithm>
 #include "ProgressIndicator.h"
 #include "Complex.h"
 #include "Concurrency.h"
 #include "Parallelizer.h"
+#include "SinglePrecisionStorage.h"
+#include "ParallelWeights.h"
 
 namespace Dmrg {
 /* PSIDOC Operators
@@ -125,6 +128,105 @@ public:
 	typedef typename PsimagLite::Vector<RealType>::Type VectorRealType;
 	typedef typename PsimagLite::Vector<SizeType>::Type VectorSizeType;
 	typedef std::pair<SizeType,SizeType> PairSizeSizeType;
+	typedef PsimagLite::Vector<bool>::Type VectorBoolType;
+	typedef typename PsimagLite::Vector<const OperatorType*>::Type VectorOperatorPtrType;
+	typedef SinglePrecisionStorage<SparseMatrixType> SinglePrecisionStorageType;
+
+	// operators[i] <-- reorder(externalProduct(*sources[i])), one task per operator;
+	// each row of the product basis is filled straight from the source
+	// operator, so the Kronecker product is never formed in the old order
+	class ParallelExternalProduct {
+
+	public:
+
+		ParallelExternalProduct(typename PsimagLite::Vector<OperatorType>::Type& operators,
+		                        const VectorOperatorPtrType& sources,
+		                        const VectorSizeType& sizes,
+		                        const VectorBoolType& options,
+		                        const VectorRealType& signsBoson,
+		                        const VectorRealType& signsFermion,
+		                        const VectorSizeType& permutation,
+		                        const VectorSizeType& permInverse)
+		    : operators_(operators),
+		      sources_(sources),
+		      sizes_(sizes),
+		      options_(options),
+		      signsBoson_(signsBoson),
+		      signsFermion_(signsFermion),
+		      permutation_(permutation),
+		      permInverse_(permInverse)
+		{}
+
+		SizeType tasks() const { return sources_.size(); }
+
+		void doTask(SizeType taskNumber, SizeType)
+		{
+			SizeType i = taskNumber;
+			assert(i < operators_.size() && i < sources_.size());
+			const OperatorType& m = *(sources_[i]);
+			const VectorRealType& signs = (m.fermionSign < 0) ? signsFermion_ : signsBoson_;
+			productInto(operators_[i].data, m.data, sizes_[i], signs, options_[i]);
+			// don't forget to set fermion sign and j:
+			operators_[i].fermionSign = m.fermionSign;
+			operators_[i].jm = m.jm;
+			operators_[i].angularFactor = m.angularFactor;
+		}
+
+	private:
+
+		// dest(r, c) = (A x I)(permutation[r], permutation[c]) if order,
+		// or (I x A)(permutation[r], permutation[c]) otherwise, with the
+		// index of the product basis being first + second*(size of first),
+		// as in PsimagLite::externalProduct; only I x A takes signs, from
+		// the states of the first factor it crosses
+		void productInto(SparseMatrixType& dest,
+		                 const SparseMatrixType& a,
+		                 SizeType nout,
+		                 const VectorRealType& signs,
+		                 bool order) const
+		{
+			SizeType na = a.rows();
+			SizeType n = na*nout;
+			dest.clear();
+			if (n == 0) return;
+
+			assert(a.cols() == na);
+			assert(permutation_.size() == n && permInverse_.size() == n);
+			assert(order || signs.size() == nout);
+			dest.resize(n, n, a.nonZeros()*nout);
+			SizeType counter = 0;
+			for (SizeType r = 0; r < n; ++r) {
+				dest.setRow(r, counter);
+				SizeType row = permutation_[r];
+				SizeType first = row % ((order) ? na : nout);
+				SizeType second = row / ((order) ? na : nout);
+				SizeType rowOfA = (order) ? first : second;
+				SizeType start = a.getRowPtr(rowOfA);
+				SizeType end = a.getRowPtr(rowOfA + 1);
+				for (SizeType k = start; k < end; ++k) {
+					SizeType col = (order) ? a.getCol(k) + second*na
+					                       : first + a.getCol(k)*nout;
+					ComplexOrRealType value = a.getValue(k);
+					if (!order) value *= signs[first];
+					dest.setCol(counter, permInverse_[col]);
+					dest.setValues(counter, value);
+					++counter;
+				}
+			}
+
+			dest.setRow(n, counter);
+			dest.checkValidity();
+		}
+
+		typename PsimagLite::Vector<OperatorType>::Type& operators_;
+		const VectorOperatorPtrType& sources_;
+		const VectorSizeType& sizes_;
+		const VectorBoolType& options_;
+		const VectorRealType& signsBoson_;
+		const VectorRealType& signsFermion_;
+		const VectorSizeType& permutation_;
+		const VectorSizeType& permInverse_;
+	};
 
 	class MyLoop {
 
@@ -135,14 +237,18 @@ public:
 		       typename PsimagLite::Vector<OperatorType>::Type& operators,
 		       const BlockDiagonalMatrixType& ftransform1,
 		       const BasisType* thisBasis1,
-		       const PairSizeSizeType& startEnd)
+		       const PairSizeSizeType& startEnd,
+		       RealType dropTolerance)
 		    : useSu2Symmetry_(useSu2Symmetry),
 		      reducedOpImpl_(reducedOpImpl),
 		      operators_(operators),
 		      ftransform(ftransform1),
 		      thisBasis(thisBasis1),
 		      hasMpi_(ConcurrencyType::hasMpi()),
-		      startEnd_(startEnd)
+		      startEnd_(startEnd),
+		      dropTolerance_(dropTolerance),
+		      removed_(ConcurrencyType::codeSectionParams.npthreads, 0),
+		      largest_(ConcurrencyType::codeSectionParams.npthreads, 0)
 		{
 			reducedOpImpl_.prepareTransform(ftransform,thisBasis);
 		}
@@ -155,10 +261,35 @@ public:
 				return;
 			}
 
-			if (!useSu2Symmetry_)
-				reducedOpImpl_.changeBasis(operators_[k].data);
-			else
+			// threads left over when there are fewer operators than threads
+			SizeType threads = ConcurrencyType::codeSectionParams.npthreads/tasks();
+			if (useSu2Symmetry_) {
 				reducedOpImpl_.changeBasis(k);
+				return;
+			}
+
+			reducedOpImpl_.changeBasis(operators_[k].data, (threads > 0) ? threads : 1);
+			if (dropTolerance_ <= 0) return;
+			assert(threadNum < removed_.size());
+			removed_[threadNum] += Operators::dropSmall(operators_[k].data,
+			                                            dropTolerance_,
+			                                            largest_[threadNum]);
+		}
+
+		SizeType removed() const
+		{
+			SizeType sum = 0;
+			for (SizeType i = 0; i < removed_.size(); ++i)
+				sum += removed_[i];
+			return sum;
+		}
+
+		RealType largest() const
+		{
+			RealType max = 0;
+			for (SizeType i = 0; i < largest_.size(); ++i)
+				if (largest_[i] > max) max = largest_[i];
+			return max;
 		}
 
 		SizeType tasks() const
@@ -211,6 +342,9 @@ public:
 		const BasisType* thisBasis;
 		bool hasMpi_;
 		const PairSizeSizeType& startEnd_;
+		RealType dropTolerance_;
+		VectorSizeType removed_;
+		VectorRealType largest_;
 	};
 
 	Operators(const BasisType* thisBasis)
@@ -247,13 +381,21 @@ public:
 	{
 		prefix += "/";
 
+		bool single = savedInSinglePrecision(io, prefix);
 		if (!useSu2Symmetry_) {
-			io.read(operators_, prefix + "Operators");
+			if (single)
+				readSinglePrecision(io, prefix + "OperatorsSingle");
+			else
+				io.read(operators_, prefix + "Operators");
 		} else {
 			if (roi) reducedOpImpl_.read(io);
 		}
 
-		io.read(hamiltonian_, prefix + "Hamiltonian");
+		if (single)
+			SinglePrecisionStorageType::read(hamiltonian_, io, prefix + "HamiltonianSingle");
+		else
+			io.read(hamiltonian_, prefix + "Hamiltonian");
+
 		reducedOpImpl_.setHamiltonian(hamiltonian_);
 	}
 
@@ -288,19 +430,37 @@ public:
 		return operators_.size();
 	}
 
+	// dropTolerance > 0 removes, from each changed operator, the entries
+	// not larger than dropTolerance times its largest entry; not for SU(2)
 	void changeBasis(const BlockDiagonalMatrixType& ftransform,
 	                 const BasisType* thisBasis,
-	                 const PairSizeSizeType& startEnd)
+	                 const PairSizeSizeType& startEnd,
+	                 RealType dropTolerance = 0)
 	{
+		if (useSu2Symmetry_) dropTolerance = 0;
+
 		typedef PsimagLite::Parallelizer<MyLoop> ParallelizerType;
 		ParallelizerType threadObject(PsimagLite::Concurrency::codeSectionParams);
 
-		MyLoop helper(useSu2Symmetry_,reducedOpImpl_,operators_,ftransform,thisBasis,startEnd);
+		MyLoop helper(useSu2Symmetry_,
+		              reducedOpImpl_,
+		              operators_,
+		              ftransform,
+		              thisBasis,
+		              startEnd,
+		              dropTolerance);
 
 		threadObject.loopCreate(helper); // FIXME: needs weights
 
 		helper.gather();
 
+		if (dropTolerance > 0) {
+			PsimagLite::OstringStream msg;
+			msg<<"Dropped "<<helper.removed()<<" entries, largest magnitude ";
+			msg<<helper.largest()<<", relative tolerance "<<dropTolerance;
+			progress_.printline(msg,std::cout);
+		}
+
 		reducedOpImpl_.changeBasisHamiltonian(hamiltonian_,ftransform);
 	}
 
@@ -310,6 +470,12 @@ public:
 			if (!useSu2Symmetry_) reorder(operators_[k].data,permutation);
 			reducedOpImpl_.reorder(k,permutation);
 		}
+
+		reorderHamiltonian(permutation);
+	}
+
+	void reorderHamiltonian(const VectorSizeType& permutation)
+	{
 		reorder(hamiltonian_,permutation);
 		reducedOpImpl_.reorderHamiltonian(permutation);
 	}
@@ -369,6 +535,42 @@ public:
 		apply(operators_[i].data);
 	}
 
+	// All operators of the enlarged block at once, already in the order
+	// of the product basis; the Hamiltonian must then be reordered
+	// with reorderHamiltonian. Factors apply only to SU(2), so there are
+	// none to apply here
+	void externalProductReordered(const VectorOperatorPtrType& sources,
+	                              const VectorSizeType& sizes,
+	                              const VectorBoolType& options,
+	                              const VectorRealType& signsBoson,
+	                              const VectorRealType& signsFermion,
+	                              const VectorSizeType& permutation,
+	                              const VectorSizeType& permInverse)
+	{
+		assert(!useSu2Symmetry_);
+		SizeType n = sources.size();
+		assert(n == operators_.size());
+		ParallelWeights::VectorLongType costs(n, 0);
+		for (SizeType i = 0; i < n; ++i)
+			costs[i] = 1 + static_cast<long unsigned int>(sources[i]->data.nonZeros())*
+			        sizes[i];
+
+		VectorSizeType weights;
+		ParallelWeights::fromCosts(weights, costs);
+
+		typedef PsimagLite::Parallelizer<ParallelExternalProduct> ParallelizerType;
+		ParallelizerType threaded(ConcurrencyType::codeSectionParams);
+		ParallelExternalProduct helper(operators_,
+		                               sources,
+		                               sizes,
+		                               options,
+		                               signsBoson,
+		                               signsFermion,
+		                               permutation,
+		                               permInverse);
+		threaded.loopCreate(helper, weights);
+	}
+
 	void externalProductReduced(SizeType i,
 	                            const BasisType& basis2,
 	                            const BasisType& basis3,
@@ -451,6 +653,43 @@ public:
 		io.write(hamiltonian_, s + "/Hamiltonian");
 	}
 
+	// values of operators and Hamiltonian as floats; read() promotes
+	// them back. With SU(2) everything is written as in write()
+	template<typename SomeIoOutType>
+	void writeSinglePrecision(SomeIoOutType& io, const PsimagLite::String& s) const
+	{
+		if (useSu2Symmetry_) {
+			write(io, s);
+			return;
+		}
+
+		PsimagLite::String label = s + "/OperatorsSingle";
+		SizeType n = operators_.size();
+		io.createGroup(label);
+		io.write(n, label + "/Size");
+		for (SizeType i = 0; i < n; ++i) {
+			const OperatorType& op = operators_[i];
+			PsimagLite::String name = label + "/" + ttos(i);
+			io.createGroup(name);
+			SinglePrecisionStorageType::write(io, name + "/data", op.data);
+			io.write(op.fermionSign, name + "/fermionSign");
+			io.write(op.jm, name + "/jm");
+			io.write(op.angularFactor, name + "/angularFactor");
+		}
+
+		SinglePrecisionStorageType::write(io, s + "/HamiltonianSingle", hamiltonian_);
+
+		SizeType single = 1;
+		io.write(single, s + "/SinglePrecision");
+	}
+
+	void swap(Operators& other)
+	{
+		reducedOpImpl_.swap(other.reducedOpImpl_);
+		operators_.swap(other.operators_);
+		hamiltonian_.swap(other.hamiltonian_);
+	}
+
 	template<typename IoOutputter>
 	void saveEmpty(IoOutputter& io,const PsimagLite::String& s) const
 	{
@@ -465,6 +704,84 @@ public:
 
 private:
 
+	template<typename IoInputter>
+	static bool savedInSinglePrecision(IoInputter& io, const PsimagLite::String& prefix)
+	{
+		SizeType single = 0;
+		try {
+			io.read(single, prefix + "SinglePrecision");
+		} catch (...) {
+			return false;
+		}
+
+		return (single == 1);
+	}
+
+	template<typename IoInputter>
+	void readSinglePrecision(IoInputter& io, const PsimagLite::String& label)
+	{
+		SizeType n = 0;
+		io.read(n, label + "/Size");
+		operators_.resize(n);
+		for (SizeType i = 0; i < n; ++i) {
+			OperatorType& op = operators_[i];
+			PsimagLite::String name = label + "/" + ttos(i);
+			SinglePrecisionStorageType::read(op.data, io, name + "/data");
+			io.read(op.fermionSign, name + "/fermionSign");
+			io.read(op.jm, name + "/jm");
+			io.read(op.angularFactor, name + "/angularFactor");
+		}
+	}
+
+	// Removes the entries of v not larger than tolerance times the largest
+	// magnitude in v; returns how many were removed, and updates largest
+	// with the largest magnitude removed
+	static SizeType dropSmall(SparseMatrixType& v,
+	                          RealType tolerance,
+	                          RealType& largest)
+	{
+		SizeType nnz = v.nonZeros();
+		if (nnz == 0) return 0;
+
+		RealType maxAbs = 0;
+		for (SizeType k = 0; k < nnz; ++k) {
+			RealType tmp = std::abs(v.getValue(k));
+			if (tmp > maxAbs) maxAbs = tmp;
+		}
+
+		RealType threshold = tolerance*maxAbs;
+		SizeType removed = 0;
+		for (SizeType k = 0; k < nnz; ++k)
+			if (std::abs(v.getValue(k)) <= threshold) ++removed;
+
+		if (removed == 0) return 0;
+
+		SizeType rows = v.rows();
+		SparseMatrixType w(rows, v.cols());
+		SizeType counter = 0;
+		for (SizeType row = 0; row < rows; ++row) {
+			w.setRow(row, counter);
+			SizeType start = v.getRowPtr(row);
+			SizeType end = v.getRowPtr(row + 1);
+			for (SizeType k = start; k < end; ++k) {
+				RealType tmp = std::abs(v.getValue(k));
+				if (tmp <= threshold) {
+					if (tmp > largest) largest = tmp;
+					continue;
+				}
+
+				w.pushCol(v.getCol(k));
+				w.pushValue(v.getValue(k));
+				++counter;
+			}
+		}
+
+		w.setRow(rows, counter);
+		w.checkValidity();
+		v = w;
+		return removed;
+	}
+
 	void reorder(SparseMatrixType &v,const   VectorSizeType& permutation)
 	{
 		if (v.rows() == 0 || v.cols() == 0) {
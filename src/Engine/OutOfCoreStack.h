@@ -0,0 +1,604 @@
+/*
+Copyright (c) 2009-2019, UT-Battelle, LLC
+All rights reserved
+
+[DMRG++, Version 5.]
+[by G.A., Oak Ridge National Laboratory]
+
+UT Battelle Open Source Software License 11242008
+
+OPEN SOURCE LICENSE
+
+Subject to the conditions of this License, each
+contributor to this software hereby grants, free of
+charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), a
+perpetual, worldwide, non-exclusive, no-charge,
+royalty-free, irrevocable copyright license to use, copy,
+modify, merge, publish, distribute, and/or sublicense
+copies of the Software.
+
+1. Redistributions of Software must retain the above
+copyright and license notices, this list of conditions,
+and the following disclaimer.  Changes or modifications
+to, or derivative works of, the Software should be noted
+with comments and the contributor and organization's
+name.
+
+2. Neither the names of UT-Battelle, LLC or the
+Department of Energy nor the names of the Software
+contributors may be used to endorse or promote products
+derived from this software without specific prior written
+permission of UT-Battelle.
+
+3. The software and the end-user documentation included
+with the redistribution, with or without modification,
+must include the following acknowledgment:
+
+"This product includes software produced by UT-Battelle,
+LLC under Contract No. DE-AC05-00OR22725  with the
+Department of Energy."
+
+*********************************************************
+DISCLAIMER
+
+THE SOFTWARE IS SUPPLIED BY THE COPYRIGHT HOLDERS AND
+CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER, CONTRIBUTORS, UNITED STATES GOVERNMENT,
+OR THE UNITED STATES DEPARTMENT OF ENERGY BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+DAMAGE.
+
+NEITHER THE UNITED STATES GOVERNMENT, NOR THE UNITED
+STATES DEPARTMENT OF ENERGY, NOR THE COPYRIGHT OWNER, NOR
+ANY OF THEIR EMPLOYEES, REPRESENTS THAT THE USE OF ANY
+INFORMATION, DATA, APPARATUS, PRODUCT, OR PROCESS
+DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
+
+*********************************************************
+*/
+
+/** \ingroup DMRG */
+/*@{*/
+
+/*! \file OutOfCoreStack.h
+ *
+ *  A stack, similar to std::stack, that keeps only its top entries
+ *  in memory; the others are saved to one scratch file each, and the
+ *  next one to be popped is read back in a background thread, or in
+ *  this one if HDF5 is not thread-safe.
+ *  Entries can also be pushed as locations in other files, see
+ *  pushFromFile(); they are read when first needed.
+ *  A snapshot gives another thread a consistent view of the stack while
+ *  this one keeps changing it; see takeSnapshot()
+ */
+
+#ifndef OUTOFCORESTACK_H
+#define OUTOFCORESTACK_H
+#include "Vector.h"
+#include "Io/IoNg.h"
+#include "ProgramGlobals.h"
+#include "IoThreads.h"
+#include <unistd.h>
+#include <cstdio>
+#include <fstream>
+#include <exception>
+#include <cassert>
+#ifdef USE_PTHREADS
+#include <pthread.h>
+#endif
+
+namespace Dmrg {
+
+template<typename DataType>
+class OutOfCoreStack {
+
+	typedef typename PsimagLite::IoNg::In IoInType;
+	typedef typename PsimagLite::IoNg::Out IoOutType;
+	typedef typename PsimagLite::Vector<DataType*>::Type VectorDataPtrType;
+	typedef PsimagLite::Vector<bool>::Type VectorBoolType;
+	typedef PsimagLite::Vector<SizeType>::Type VectorSizeType;
+	typedef PsimagLite::Vector<PsimagLite::String>::Type VectorStringType;
+
+public:
+
+	// an entry is either in memory (data) or in group of a file; id is
+	// the generation of the entry, unique within this stack; linked
+	// files belong to the snapshot
+	struct SnapshotEntry {
+
+		SnapshotEntry(const DataType* d,
+		              PsimagLite::String f,
+		              PsimagLite::String g,
+		              SizeType i,
+		              bool l)
+		    : data(d), file(f), group(g), id(i), linked(l)
+		{}
+
+		const DataType* data;
+		PsimagLite::String file;
+		PsimagLite::String group;
+		SizeType id;
+		bool linked;
+	};
+
+	// entries are top first
+	struct Snapshot {
+
+		Snapshot() : isObserveCode(false) {}
+
+		PsimagLite::String label;
+		bool isObserveCode;
+		typename PsimagLite::Vector<SnapshotEntry>::Type entries;
+		VectorDataPtrType owned;
+	};
+
+	// maxResident == 0 keeps all entries in memory
+	OutOfCoreStack(PsimagLite::String filename,
+	               PsimagLite::String label,
+	               SizeType maxResident,
+	               bool isObserveCode)
+	    : filename_(filename),
+	      label_(label),
+	      maxResident_(maxResident),
+	      isObserveCode_(isObserveCode),
+	      total_(0),
+	      nextId_(0),
+	      prefetched_(0),
+	      prefetchIndex_(0),
+	      prefetchRunning_(false),
+	      snapshotActive_(false)
+	{}
+
+	~OutOfCoreStack()
+	{
+		joinPrefetch();
+		delete prefetched_;
+		prefetched_ = 0;
+
+		for (SizeType i = 0; i < resident_.size(); ++i) {
+			delete resident_[i];
+			resident_[i] = 0;
+		}
+
+		freeRetired();
+
+		for (SizeType i = 0; i < hasFile_.size(); ++i)
+			if (hasFile_[i]) unlink(slotFilename(i).c_str());
+
+		for (SizeType i = 0; i < links_.size(); ++i)
+			unlink(links_[i].c_str());
+	}
+
+	void push(const DataType& d)
+	{
+		waitForPrefetch();
+
+		setLocation(total_, false, "", "");
+		resident_.push_back(new DataType(d));
+		ids_.push_back(nextId_++);
+		++total_;
+
+		while (maxResident_ > 0 && resident_.size() > maxResident_)
+			spillBottom();
+	}
+
+	// pushes the entry saved in group of file without reading it; it is
+	// read when it is first needed. Only below in-memory entries, as
+	// on restart. The file is linked (or copied) to a private name, so
+	// that it can be replaced while this stack still needs it
+	void pushFromFile(PsimagLite::String file, PsimagLite::String group)
+	{
+		if (resident_.size() > 0)
+			err("OutOfCoreStack: pushFromFile() onto in-memory entries\n");
+
+		waitForPrefetch();
+
+		setLocation(total_, true, privateCopyOf(file), group);
+		ids_.push_back(nextId_++);
+		++total_;
+	}
+
+	void pop()
+	{
+		if (total_ == 0)
+			err("OutOfCoreStack: Can't pop; the stack is empty!\n");
+
+		waitForPrefetch();
+
+		// the top may not have been read yet
+		if (resident_.size() > 0) {
+			retire(resident_.back());
+			resident_.pop_back();
+		}
+
+		ids_.pop_back();
+		--total_;
+
+		if (total_ == 0) return;
+
+		// top() must never wait
+		if (resident_.size() == 0)
+			resident_.push_back(load(total_ - 1));
+
+		startPrefetch();
+	}
+
+	const DataType& top() const
+	{
+		assert(total_ > 0);
+		if (resident_.size() == 0) {
+			waitForPrefetch();
+			if (resident_.size() == 0)
+				resident_.push_back(load(total_ - 1));
+		}
+
+		return *resident_.back();
+	}
+
+	SizeType size() const { return total_; }
+
+	// writes the entries, top first, as label/Size and label/i;
+	// entries in files are read one at a time, nothing else is copied
+	template<typename SomeIoOutType>
+	void write(SomeIoOutType& io, PsimagLite::String label) const
+	{
+		waitForPrefetch();
+
+		io.createGroup(label);
+		io.write(total_, label + "/Size");
+		SizeType n = resident_.size();
+		for (SizeType i = 0; i < total_; ++i) {
+			PsimagLite::String name(label + "/" + ttos(i));
+			if (i < n) {
+				resident_[n - 1 - i]->write(io,
+				                            name,
+				                            SomeIoOutType::Serializer::NO_OVERWRITE,
+				                            saveOption());
+				continue;
+			}
+
+			DataType* dt = load(total_ - 1 - i);
+			try {
+				dt->write(io, name, SomeIoOutType::Serializer::NO_OVERWRITE, saveOption());
+			} catch (...) {
+				delete dt;
+				throw;
+			}
+
+			delete dt;
+		}
+	}
+
+	// pushes the entries saved by write() in file, without reading them
+	void pushAllFromFile(PsimagLite::String file, PsimagLite::String label)
+	{
+		IoInType io(file);
+		SizeType n = 0;
+		io.read(n, label + "/Size");
+		io.close();
+
+		for (SizeType i = 0; i < n; ++i)
+			pushFromFile(file, label + "/" + ttos(n - 1 - i));
+	}
+
+	// Copy-on-write view for another thread: in-memory entries are shared,
+	// and entries that this stack drops in the meantime are freed only by
+	// releaseSnapshot(); entries in files are hard linked, and spills
+	// replace slot files by renaming, so a link keeps its contents.
+	// Shared entries are only read, through const members, which must
+	// therefore not change DataType (no mutable caches in it)
+	void takeSnapshot(Snapshot& snapshot) const
+	{
+		if (snapshotActive_)
+			err("OutOfCoreStack: a snapshot is already active\n");
+
+		waitForPrefetch();
+
+		snapshot.label = label_;
+		snapshot.isObserveCode = isObserveCode_;
+		snapshot.entries.clear();
+		snapshot.owned.clear();
+
+		SizeType n = resident_.size();
+		for (SizeType i = 0; i < n; ++i) {
+			const DataType* dt = resident_[n - 1 - i];
+			snapshot.entries.push_back(SnapshotEntry(dt, "", "", ids_[total_ - 1 - i], false));
+		}
+
+		SizeType first = total_ - n;
+		for (SizeType i = 0; i < first; ++i) {
+			SizeType ind = first - 1 - i;
+
+			// private copies of other files do not change while this
+			// stack lives
+			if (files_[ind] != "") {
+				snapshot.entries.push_back(SnapshotEntry(0,
+				                                         files_[ind],
+				                                         groups_[ind],
+				                                         ids_[ind],
+				                                         false));
+				continue;
+			}
+
+			PsimagLite::String linkName(slotFilename(ind) + ".snapshot");
+			unlink(linkName.c_str());
+			if (link(slotFilename(ind).c_str(), linkName.c_str()) == 0) {
+				snapshot.entries.push_back(SnapshotEntry(0, linkName, label_, ids_[ind], true));
+				continue;
+			}
+
+			// no hard links here; fall back to a copy
+			DataType* dt = load(ind);
+			snapshot.owned.push_back(dt);
+			snapshot.entries.push_back(SnapshotEntry(dt, "", "", ids_[ind], false));
+		}
+
+		snapshotActive_ = true;
+	}
+
+	// pushes entry i of the snapshot into other; may run on any thread
+	template<typename OtherStackType>
+	static void pushSnapshotEntryInto(OtherStackType& other,
+	                                  const Snapshot& snapshot,
+	                                  SizeType i)
+	{
+		assert(i < snapshot.entries.size());
+		const SnapshotEntry& entry = snapshot.entries[i];
+		if (entry.data) {
+			other.push(*entry.data);
+			return;
+		}
+
+		IoInType io(entry.file);
+		DataType dt(io, entry.group, snapshot.isObserveCode);
+		io.close();
+		other.push(dt);
+	}
+
+	void releaseSnapshot(Snapshot& snapshot) const
+	{
+		for (SizeType i = 0; i < snapshot.entries.size(); ++i)
+			if (snapshot.entries[i].linked)
+				unlink(snapshot.entries[i].file.c_str());
+
+		for (SizeType i = 0; i < snapshot.owned.size(); ++i)
+			delete snapshot.owned[i];
+
+		snapshot.entries.clear();
+		snapshot.owned.clear();
+		snapshotActive_ = false;
+		freeRetired();
+	}
+
+private:
+
+	OutOfCoreStack(const OutOfCoreStack&);
+
+	OutOfCoreStack& operator=(const OutOfCoreStack&);
+
+	static SizeType saveOption()
+	{
+		return (ProgramGlobals::stacksSinglePrecision) ? DataType::SAVE_ALL_SINGLE :
+		                                                 DataType::SAVE_ALL;
+	}
+
+	// writes the bottom resident entry to its file unless the file is
+	// already current, and frees it
+	void spillBottom()
+	{
+		assert(resident_.size() > 0);
+		SizeType ind = total_ - resident_.size();
+		assert(ind < inFile_.size());
+
+		if (!inFile_[ind]) {
+			PsimagLite::String name(slotFilename(ind));
+			PsimagLite::String tmpName(name + ".tmp");
+			IoOutType io(tmpName, PsimagLite::IoNg::ACC_TRUNC);
+			resident_[0]->write(io,
+			                    label_,
+			                    IoOutType::Serializer::NO_OVERWRITE,
+			                    saveOption());
+			io.close();
+			if (rename(tmpName.c_str(), name.c_str()) != 0)
+				err("OutOfCoreStack: cannot rename " + tmpName + "\n");
+
+			setLocation(ind, true, "", "");
+			if (hasFile_.size() <= ind) hasFile_.resize(ind + 1, false);
+			hasFile_[ind] = true;
+		}
+
+		retire(resident_[0]);
+		resident_.erase(resident_.begin());
+	}
+
+	// entries still seen by a snapshot are freed when it is released
+	void retire(DataType* dt)
+	{
+		if (snapshotActive_) retired_.push_back(dt);
+		else delete dt;
+	}
+
+	void freeRetired() const
+	{
+		for (SizeType i = 0; i < retired_.size(); ++i)
+			delete retired_[i];
+
+		retired_.clear();
+	}
+
+	// an empty file and group mean the slot file of ind
+	void setLocation(SizeType ind,
+	                 bool inFile,
+	                 PsimagLite::String file,
+	                 PsimagLite::String group)
+	{
+		if (inFile_.size() <= ind) {
+			inFile_.resize(ind + 1, false);
+			files_.resize(ind + 1);
+			groups_.resize(ind + 1);
+		}
+
+		inFile_[ind] = inFile;
+		files_[ind] = file;
+		groups_[ind] = group;
+	}
+
+	DataType* load(SizeType ind) const
+	{
+		assert(ind < inFile_.size() && inFile_[ind]);
+		PsimagLite::String file = (files_[ind] == "") ? slotFilename(ind) : files_[ind];
+		PsimagLite::String group = (groups_[ind] == "") ? label_ : groups_[ind];
+		try {
+			IoInType io(file);
+			DataType* dt = new DataType(io, group, isObserveCode_);
+			io.close();
+			return dt;
+		} catch (std::exception& e) {
+			PsimagLite::String msg("OutOfCoreStack: cannot read " + group);
+			msg += " from " + file + ": " + e.what();
+			throw PsimagLite::RuntimeError(msg);
+		}
+	}
+
+	// links file to a private name, or copies it if links are not
+	// supported; once per file
+	PsimagLite::String privateCopyOf(PsimagLite::String file)
+	{
+		for (SizeType i = 0; i < linkedFiles_.size(); ++i)
+			if (linkedFiles_[i] == file) return links_[i];
+
+		PsimagLite::String name(scratchFilename("Restart" + label_ + ttos(links_.size())));
+		unlink(name.c_str());
+		if (link(file.c_str(), name.c_str()) != 0) {
+			std::ifstream fin(file.c_str(), std::ios::binary);
+			std::ofstream fout(name.c_str(), std::ios::binary);
+			fout<<fin.rdbuf();
+			if (!fin || !fout)
+				err("OutOfCoreStack: cannot copy " + file + " to " + name + "\n");
+		}
+
+		linkedFiles_.push_back(file);
+		links_.push_back(name);
+		return name;
+	}
+
+	// reads the entry below the resident ones, if there is room for it;
+	// with all entries in memory only entries not yet read are below
+	void startPrefetch()
+	{
+		SizeType first = total_ - resident_.size();
+		if (first == 0) return;
+		if (maxResident_ > 0 && resident_.size() >= maxResident_) return;
+
+		prefetchIndex_ = first - 1;
+		prefetchRunning_ = true;
+
+#ifdef USE_PTHREADS
+		if (IoThreads::enabled() &&
+		        pthread_create(&thread_, 0, prefetchThread, this) == 0) return;
+#endif
+
+		prefetchRunning_ = false;
+		prefetchThread(this);
+		addPrefetched();
+	}
+
+	static void* prefetchThread(void* arg)
+	{
+		OutOfCoreStack* self = static_cast<OutOfCoreStack*>(arg);
+		try {
+			self->prefetched_ = self->load(self->prefetchIndex_);
+		} catch (std::exception& e) {
+			self->prefetchError_ = e.what();
+		}
+
+		return 0;
+	}
+
+	void joinPrefetch() const
+	{
+		if (!prefetchRunning_) return;
+
+#ifdef USE_PTHREADS
+		pthread_join(thread_, 0);
+#endif
+
+		prefetchRunning_ = false;
+	}
+
+	void waitForPrefetch() const
+	{
+		joinPrefetch();
+		addPrefetched();
+	}
+
+	void addPrefetched() const
+	{
+		if (prefetchError_ != "") {
+			PsimagLite::String msg("OutOfCoreStack: prefetch failed: ");
+			msg += prefetchError_ + "\n";
+			prefetchError_ = "";
+			err(msg);
+		}
+
+		if (!prefetched_) return;
+
+		assert(prefetchIndex_ + resident_.size() + 1 == total_);
+		resident_.insert(resident_.begin(), prefetched_);
+		prefetched_ = 0;
+	}
+
+	PsimagLite::String slotFilename(SizeType ind) const
+	{
+		return scratchFilename("Stack" + label_ + ttos(ind));
+	}
+
+	// same directory as filename_
+	PsimagLite::String scratchFilename(PsimagLite::String name) const
+	{
+		size_t x = filename_.find_last_of("/");
+		if (x == PsimagLite::String::npos) return name + filename_;
+		return filename_.substr(0, x + 1) + name + filename_.substr(x + 1);
+	}
+
+	PsimagLite::String filename_;
+	PsimagLite::String label_;
+	SizeType maxResident_;
+	bool isObserveCode_;
+	SizeType total_;
+	VectorSizeType ids_;
+	SizeType nextId_;
+	// the prefetch can complete from const members
+	mutable VectorDataPtrType resident_;
+	VectorBoolType inFile_;
+	VectorBoolType hasFile_;
+	VectorStringType files_;
+	VectorStringType groups_;
+	VectorStringType linkedFiles_;
+	VectorStringType links_;
+	mutable DataType* prefetched_;
+	SizeType prefetchIndex_;
+	mutable bool prefetchRunning_;
+	mutable PsimagLite::String prefetchError_;
+	mutable bool snapshotActive_;
+	mutable VectorDataPtrType retired_;
+#ifdef USE_PTHREADS
+	pthread_t thread_;
+#endif
+}; // class OutOfCoreStack
+} // namespace Dmrg
+
+/*@}*/
+#endif
+
@@ -79,9 +79,15 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 
 #include "ProgramGlobals.h"
 #include "Concurrency.h"
+#include "BLAS.h"
 
 namespace Dmrg {
 
+/* Adds weight*psi*psi^dagger to each block of the density matrix.
+   The target vector is first reshaped, sector by sector, into dense
+   matrices psi(alpha, beta) with alpha in one partition of pBasis and
+   beta in one partition of pBasisSummed, so that each block is a sum of
+   BLAS-3 products; tasks are the blocks (partitions of pBasis) */
 template<typename BlockMatrixType,
          typename BasisWithOperatorsType,
          typename TargetVectorType>
@@ -91,121 +97,117 @@ class ParallelDensityMatrix {
 	typedef typename TargetVectorType::value_type DensityMatrixElementType;
 	typedef typename BasisWithOperatorsType::BasisType BasisType;
 	typedef PsimagLite::Concurrency ConcurrencyType;
+	typedef typename PsimagLite::Vector<SizeType>::Type VectorSizeType;
+	typedef typename PsimagLite::Vector<VectorSizeType>::Type VectorVectorSizeType;
+	typedef typename PsimagLite::Vector<int>::Type VectorIntType;
 
 public:
 
 	typedef typename PsimagLite::Real<DensityMatrixElementType>::Type RealType;
+	typedef typename PsimagLite::Vector<BuildingBlockType>::Type VectorBuildingBlockType;
 
 	ParallelDensityMatrix(const TargetVectorType& target,
 	                      const BasisWithOperatorsType& pBasis,
 	                      const BasisWithOperatorsType& pBasisSummed,
 	                      const BasisType& pSE,
 	                      ProgramGlobals::DirectionEnum direction,
-	                      SizeType m,
 	                      RealType weight,
-	                      BuildingBlockType& matrixBlock)
+	                      VectorBuildingBlockType& matrixBlocks)
 	    : target_(target),
 	      pBasis_(pBasis),
 	      pBasisSummed_(pBasisSummed),
 	      pSE_(pSE),
 	      direction_(direction),
-	      m_(m),
 	      weight_(weight),
-	      matrixBlock_(matrixBlock),
-	      hasMpi_(PsimagLite::Concurrency::hasMpi())
-	{}
-
-	SizeType tasks() const
+	      matrixBlocks_(matrixBlocks),
+	      blocksOfPartition_(matrixBlocks.size())
 	{
-		return pBasis_.partition(m_+1) - pBasis_.partition(m_);
+		assert(matrixBlocks_.size() + 1 == pBasis_.partition());
+		reshape();
 	}
 
-	void doTask(SizeType taskNumber, SizeType threadNum)
+	SizeType tasks() const { return matrixBlocks_.size(); }
+
+	void doTask(SizeType m, SizeType)
 	{
-		SizeType start = pBasis_.partition(m_);
-		SizeType length = pBasis_.partition(m_+1) - start;
-
-		SizeType ieff = taskNumber + start;
-		for (SizeType j = 0; j < length; ++j) {
-			matrixBlock_(taskNumber,j) += densityMatrixExpand(direction_,
-			                                          ieff,
-			                                          j+start,
-			                                          target_)*weight_;
+		const VectorSizeType& blocks = blocksOfPartition_[m];
+		BuildingBlockType& matrixBlock = matrixBlocks_[m];
+		SizeType rows = matrixBlock.rows();
+		for (SizeType i = 0; i < blocks.size(); ++i) {
+			const BuildingBlockType& psi = psi_[blocks[i]];
+			assert(psi.rows() == rows);
+			SizeType cols = psi.cols();
+			if (rows == 0 || cols == 0) continue;
+			psimag::BLAS::GEMM('N',
+			                   'C',
+			                   rows,
+			                   rows,
+			                   cols,
+			                   weight_,
+			                   &(psi(0,0)),
+			                   rows,
+			                   &(psi(0,0)),
+			                   rows,
+			                   1.0,
+			                   &(matrixBlock(0,0)),
+			                   rows);
 		}
 	}
 
 private:
 
-	DensityMatrixElementType densityMatrixExpand(ProgramGlobals::DirectionEnum direction,
-	                                             SizeType alpha1,
-	                                             SizeType alpha2,
-	                                             const TargetVectorType& v)
+	// one pass over the target vector; each of its elements lands in exactly
+	// one dense psi, because the partitions of a sector have fixed symmetry
+	void reshape()
 	{
-		if (direction == ProgramGlobals::EXPAND_SYSTEM)
-			return densityMatrixExpandSystem(alpha1,
-			                                 alpha2,
-			                                 v);
-		else
-			return densityMatrixExpandEnviron(alpha1,
-			                                  alpha2,
-			                                  v);
-
-	}
-
-	DensityMatrixElementType densityMatrixExpandEnviron(SizeType alpha1,
-	                                                    SizeType alpha2,
-	                                                    const TargetVectorType& v)
-	{
-		SizeType ns = pBasisSummed_.size();
-		SizeType total = pBasisSummed_.size();
-		DensityMatrixElementType sum=0;
-
-		SizeType x2 = alpha2*ns;
-		SizeType x1 = alpha1*ns;
-		for (SizeType beta=0;beta<total;beta++) {
-			SizeType ii = pSE_.permutationInverse(beta + x1);
-			int sector1 = v.index2Sector(ii);
-			if (sector1 < 0) continue;
-			SizeType start1 = v.offset(sector1);
-
-			SizeType jj = pSE_.permutationInverse(beta + x2);
-			int sector2 = v.index2Sector(jj);
-			if (sector2 < 0) continue;
-			SizeType start2 = v.offset(sector2);
-
-			sum += v.fastAccess(sector1,ii-start1)*
-			        PsimagLite::conj(v.fastAccess(sector2,jj-start2));
+		VectorSizeType partitionOf;
+		VectorSizeType partitionOfSummed;
+		findPartitions(partitionOf, pBasis_);
+		findPartitions(partitionOfSummed, pBasisSummed_);
+
+		const bool expandSys = (direction_ == ProgramGlobals::EXPAND_SYSTEM);
+		// size of the left basis, which is pBasis when expanding the system
+		SizeType ns = (expandSys) ? pBasis_.size() : pBasisSummed_.size();
+		VectorIntType psiIndex(matrixBlocks_.size());
+		VectorSizeType summedPartition;
+
+		for (SizeType ii = 0; ii < target_.sectors(); ++ii) {
+			SizeType i0 = target_.sector(ii);
+			SizeType offset = target_.offset(i0);
+			SizeType total = target_.effectiveSize(i0);
+			std::fill(psiIndex.begin(), psiIndex.end(), -1);
+
+			for (SizeType i = 0; i < total; ++i) {
+				SizeType x = pSE_.permutation(i + offset);
+				SizeType alpha = (expandSys) ? x % ns : x / ns;
+				SizeType beta = (expandSys) ? x / ns : x % ns;
+				SizeType m = partitionOf[alpha];
+				SizeType p = partitionOfSummed[beta];
+
+				if (psiIndex[m] < 0) {
+					psiIndex[m] = psi_.size();
+					blocksOfPartition_[m].push_back(psi_.size());
+					summedPartition.push_back(p);
+					SizeType rows = pBasis_.partition(m + 1) - pBasis_.partition(m);
+					SizeType cols = pBasisSummed_.partition(p + 1) - pBasisSummed_.partition(p);
+					psi_.push_back(BuildingBlockType(rows, cols));
+				}
+
+				SizeType index = psiIndex[m];
+				assert(summedPartition[index] == p);
+				psi_[index](alpha - pBasis_.partition(m),
+				            beta - pBasisSummed_.partition(p)) = target_.fastAccess(i0, i);
+			}
 		}
-		return sum;
 	}
 
-	DensityMatrixElementType densityMatrixExpandSystem(SizeType alpha1,
-	                                                   SizeType alpha2,
-	                                                   const TargetVectorType& v)
+	static void findPartitions(VectorSizeType& partitionOf, const BasisType& basis)
 	{
-		SizeType ne = pBasisSummed_.size();
-		SizeType ns = pSE_.size()/ne;
-		SizeType total = pBasisSummed_.size();
-		DensityMatrixElementType sum=0;
-
-		SizeType totalNs = total * ns;
-
-		for (SizeType betaNs=0;betaNs<totalNs;betaNs+=ns) {
-			SizeType ii = pSE_.permutationInverse(alpha1+betaNs);
-			int sector1 = v.index2Sector(ii);
-			if (sector1 < 0) continue;
-			SizeType start1 = v.offset(sector1);
-
-			SizeType jj = pSE_.permutationInverse(alpha2+betaNs);
-			int sector2 = v.index2Sector(jj);
-			if (sector2 < 0) continue;
-			SizeType start2 = v.offset(sector2);
-
-			sum += v.fastAccess(sector1,ii-start1)*
-			        PsimagLite::conj(v.fastAccess(sector2,jj-start2));
-		}
-
-		return sum;
+		partitionOf.resize(basis.size());
+		SizeType total = basis.partition() - 1;
+		for (SizeType m = 0; m < total; ++m)
+			for (SizeType a = basis.partition(m); a < basis.partition(m + 1); ++a)
+				partitionOf[a] = m;
 	}
 
 	const TargetVectorType& target_;
@@ -213,13 +215,12 @@ private:
 	const BasisWithOperatorsType& pBasisSummed_;
 	const BasisType& pSE_;
 	ProgramGlobals::DirectionEnum direction_;
-	SizeType m_;
 	RealType weight_;
-	BuildingBlockType& matrixBlock_;
-	bool hasMpi_;
+	VectorBuildingBlockType& matrixBlocks_;
+	VectorVectorSizeType blocksOfPartition_;
+	VectorBuildingBlockType psi_;
 }; // class ParallelDensityMatrix
 } // namespace Dmrg
 
 /*@}*/
 #endif // PARALLEL_DENSITY_MATRIX_H
-
@@ -126,6 +126,27 @@ The first movement starts from where the infinite loop left off, at the middle o
  lattice.
 See the below for more information and examples on Finite Loops.
 
+\item[LanczosMaxVectors=integer] Optional. If positive, the ground state is found
+with a thick-restart Lanczos that keeps at most this many Krylov vectors in memory,
+instead of the usual Lanczos solver. LanczosEps and LanczosSteps still apply,
+with the same convergence criterion as the usual solver.
+Not available with Excited or useDavidson. Defaults to 0 (disabled).
+
+\item[OperatorsDropTolerance=real] Optional. If positive, after each change of
+basis, entries of a stored block operator whose magnitude is at most this
+number times the largest magnitude in that operator are removed. The number is
+capped by the truncation error of the step, the sum of the density-matrix
+eigenvalues discarded by that step, so a step that discards nothing removes no
+entries. The number of entries removed and the largest removed magnitude are
+printed. Not used with SU(2).
+Defaults to 0 (disabled).
+
+\item[ObserverCacheMegabytes=integer] Optional. Only for observe. Data saved
+for each step of the finite loops is read when a measurement first needs it,
+and kept in memory up to about this many megabytes, after which the least
+recently used is dropped and read again if needed.
+Defaults to 0 (no limit).
+
 \end{itemize}
 */
 template<typename FieldType,typename InputValidatorType, typename QnType>
@@ -149,6 +170,8 @@ struct ParametersDmrgSolver {
 	SizeType dumperEnd;
 	SizeType precision;
 	SizeType recoveryMaxFiles;
+	SizeType lanczosMaxVectors;
+	SizeType observerCacheMegabytes;
 	int useReflectionSymmetry;
 	bool autoRestart;
 	PairRealSizeType truncationControl;
@@ -164,6 +187,7 @@ struct ParametersDmrgSolver {
 	VectorFiniteLoopType finiteLoop;
 	FieldType degeneracyMax;
 	FieldType denseSparseThreshold;
+	FieldType operatorsDropTolerance;
 
 	void write(PsimagLite::String label,
 	           PsimagLite::IoSerializer& ioSerializer) const
@@ -190,11 +214,14 @@ struct ParametersDmrgSolver {
 		ioSerializer.write(root + "/fileForDensityMatrixEigs", fileForDensityMatrixEigs);
 		ioSerializer.write(root + "/recoverySave", recoverySave);
 		ioSerializer.write(root + "/recoveryMaxFiles", recoveryMaxFiles);
+		ioSerializer.write(root + "/lanczosMaxVectors", lanczosMaxVectors);
+		ioSerializer.write(root + "/observerCacheMegabytes", observerCacheMegabytes);
 		checkpoint.write(label + "/checkpoint", ioSerializer);
 		ioSerializer.write(root + "/adjustQuantumNumbers", adjustQuantumNumbers);
 		ioSerializer.write(root + "/finiteLoop", finiteLoop);
 		ioSerializer.write(root + "/degeneracyMax", degeneracyMax);
 		ioSerializer.write(root + "/denseSparseThreshold", denseSparseThreshold);
+		ioSerializer.write(root + "/operatorsDropTolerance", operatorsDropTolerance);
 	}
 
 	template<typename SomeMemResolvType>
@@ -217,11 +244,14 @@ struct ParametersDmrgSolver {
 	      dumperEnd(0),
 	      precision(6),
 	      recoveryMaxFiles(3),
+	      lanczosMaxVectors(0),
+	      observerCacheMegabytes(0),
 	      autoRestart(false),
 	      recoverySave("no"),
 	      adjustQuantumNumbers(0, QnType(0, VectorSizeType(), PairSizeType(0, 0), 0)),
 	      degeneracyMax(1e-12),
-	      denseSparseThreshold(0.2)
+	      denseSparseThreshold(0.2),
+	      operatorsDropTolerance(0)
 	{
 		io.readline(model,"Model=");
 		io.readline(options,"SolverOptions=");
@@ -351,6 +381,25 @@ struct ParametersDmrgSolver {
 			io.readline(denseSparseThreshold, "DenseSparseThreshold=");
 		} catch (std::exception&) {}
 
+		try {
+			io.readline(lanczosMaxVectors, "LanczosMaxVectors=");
+		} catch (std::exception&) {}
+
+		try {
+			io.readline(operatorsDropTolerance, "OperatorsDropTolerance=");
+		} catch (std::exception&) {}
+
+		try {
+			io.readline(observerCacheMegabytes, "ObserverCacheMegabytes=");
+		} catch (std::exception&) {}
+
+		if (lanczosMaxVectors > 0) {
+			if (excited > 0 || options.find("useDavidson") != PsimagLite::String::npos) {
+				PsimagLite::String msg("FATAL: LanczosMaxVectors cannot run with ");
+				throw PsimagLite::RuntimeError(msg + "Excited > 0 or useDavidson\n");
+			}
+		}
+
 		if (isObserveCode) return;
 		bool hasRestart = false;
 		if (options.find("restart")!=PsimagLite::String::npos) {
@@ -525,6 +574,12 @@ struct ParametersDmrgSolver {
 
 		os<<"parameters.degeneracyMax="<<p.degeneracyMax<<"\n";
 		os<<"parameters.denseSparseThreshold="<<p.denseSparseThreshold<<"\n";
+		if (p.lanczosMaxVectors > 0)
+			os<<"parameters.lanczosMaxVectors="<<p.lanczosMaxVectors<<"\n";
+		if (p.operatorsDropTolerance > 0)
+			os<<"parameters.operatorsDropTolerance="<<p.operatorsDropTolerance<<"\n";
+		if (p.observerCacheMegabytes > 0)
+			os<<"parameters.observerCacheMegabytes="<<p.observerCacheMegabytes<<"\n";
 		os<<"parameters.nthreads="<<p.nthreads<<"\n";
 		os<<"parameters.useReflectionSymmetry="<<p.useReflectionSymmetry<<"\n";
 		os<<p.checkpoint;
@@ -90,6 +90,8 @@ struct ProgramGlobals {
 
 	static bool oldChangeOfBasis;
 
+	static bool stacksSinglePrecision;
+
 	static const PsimagLite::String license;
 
 	static const SizeType MAX_LPS = 1000;
@@ -236,6 +236,23 @@ public:
 		}
 	}
 
+	// Flattens this Qn into key, such that two Qns are equal (operator==)
+	// if and only if their keys are equal
+	void pack(VectorSizeType& key) const
+	{
+		SizeType n = other.size();
+		assert(n == 0 || n == modalStruct.size());
+		key.resize(n + 4);
+		key[0] = electrons;
+		for (SizeType i = 0; i < n; ++i)
+			key[1 + i] = (modalStruct[i].modalEnum == MODAL_MODULO) ?
+			            other[i] % modalStruct[i].extra : other[i];
+
+		key[n + 1] = jmPair.first;
+		key[n + 2] = jmPair.second;
+		key[n + 3] = flavors;
+	}
+
 	static void qnToElectrons(VectorSizeType& electrons, const VectorQnType& qns)
 	{
 		electrons.resize(qns.size());
@@ -0,0 +1,365 @@
+/*
+Copyright (c) 2009-2019, UT-Battelle, LLC
+All rights reserved
+
+[DMRG++, Version 5.]
+[by G.A., Oak Ridge National Laboratory]
+
+UT Battelle Open Source Software License 11242008
+
+OPEN SOURCE LICENSE
+
+Subject to the conditions of this License, each
+contributor to this software hereby grants, free of
+charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), a
+perpetual, worldwide, non-exclusive, no-charge,
+royalty-free, irrevocable copyright license to use, copy,
+modify, merge, publish, distribute, and/or sublicense
+copies of the Software.
+
+1. Redistributions of Software must retain the above
+copyright and license notices, this list of conditions,
+and the following disclaimer.  Changes or modifications
+to, or derivative works of, the Software should be noted
+with comments and the contributor and organization's
+name.
+
+2. Neither the names of UT-Battelle, LLC or the
+Department of Energy nor the names of the Software
+contributors may be used to endorse or promote products
+derived from this software without specific prior written
+permission of UT-Battelle.
+
+3. The software and the end-user documentation included
+with the redistribution, with or without modification,
+must include the following acknowledgment:
+
+"This product includes software produced by UT-Battelle,
+LLC under Contract No. DE-AC05-00OR22725  with the
+Department of Energy."
+
+*********************************************************
+DISCLAIMER
+
+THE SOFTWARE IS SUPPLIED BY THE COPYRIGHT HOLDERS AND
+CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER, CONTRIBUTORS, UNITED STATES GOVERNMENT,
+OR THE UNITED STATES DEPARTMENT OF ENERGY BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+DAMAGE.
+
+NEITHER THE UNITED STATES GOVERNMENT, NOR THE UNITED
+STATES DEPARTMENT OF ENERGY, NOR THE COPYRIGHT OWNER, NOR
+ANY OF THEIR EMPLOYEES, REPRESENTS THAT THE USE OF ANY
+INFORMATION, DATA, APPARATUS, PRODUCT, OR PROCESS
+DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
+
+*********************************************************
+
+*/
+
+/** \ingroup DMRG */
+/*@{*/
+
+/*! \file RandomizedEigs.h
+ *
+ *  Leading eigenpairs of one symmetry block of the density matrix,
+ *  rho or rho = psi psi^dagger, with a randomized range finder
+ *  (N. Halko, P. G. Martinsson, and J. A. Tropp, SIAM Rev. 53, 217 (2011))
+ *  followed by Rayleigh-Ritz. Used by Truncation when
+ *  SolverOptions contains truncationRandomized
+ *
+ */
+#ifndef RANDOMIZED_EIGS_H
+#define RANDOMIZED_EIGS_H
+
+#include "Matrix.h"
+#include "Vector.h"
+#include "BLAS.h"
+#include "Random48.h"
+#include <algorithm>
+#include <functional>
+
+namespace Dmrg {
+
+template<typename MatrixType>
+class RandomizedEigs {
+
+	typedef typename MatrixType::value_type ComplexOrRealType;
+	typedef typename PsimagLite::Real<ComplexOrRealType>::Type RealType;
+
+public:
+
+	typedef typename PsimagLite::Vector<RealType>::Type VectorRealType;
+	typedef typename PsimagLite::Vector<bool>::Type VectorBoolType;
+
+	enum {OVERSAMPLING = 8, POWER_ITERATIONS = 2};
+
+	/* If isFactor is true then the block is a*a^dagger, else it is a */
+	RandomizedEigs(const MatrixType& a, bool isFactor)
+	    : a_(a), isFactor_(isFactor)
+	{}
+
+	// states to compute for a block of size n, given its share of kept
+	// out of total; zero means that a full diagonalization is cheaper
+	static SizeType rank(SizeType n, SizeType total, SizeType kept)
+	{
+		if (total == 0) return 0;
+		SizeType k = (2*n*kept)/total + OVERSAMPLING;
+		if (k > kept) k = kept;
+		return (2*(k + OVERSAMPLING) < n) ? k : 0;
+	}
+
+	/* On output, u is n x n: its last k columns are the leading Ritz
+	   vectors, in ascending order, and its first n - k columns are
+	   placeholders that Truncation always removes. eigs has n entries;
+	   the first n - k share the weight not captured, returned in residual.
+	   Returns false if the Ritz pairs are not accurate enough */
+	bool operator()(MatrixType& u,
+	                VectorRealType& eigs,
+	                RealType& residual,
+	                SizeType k) const
+	{
+		SizeType n = a_.rows();
+		SizeType l = k + OVERSAMPLING;
+		assert(l < n);
+
+		MatrixType q(n, l);
+		PsimagLite::Random48<RealType> rng(3433117 + n);
+		for (SizeType j = 0; j < l; ++j)
+			for (SizeType i = 0; i < n; ++i)
+				q(i, j) = rng() - 0.5;
+
+		MatrixType z;
+		for (SizeType it = 0; it <= POWER_ITERATIONS; ++it) {
+			apply(z, q);
+			q = z;
+			if (!orthonormalize(q, rng)) return false;
+		}
+
+		apply(z, q);
+
+		// Rayleigh-Ritz in the subspace spanned by q
+		MatrixType b(l, l);
+		gemm('C', 'N', q, z, b);
+		for (SizeType i = 0; i < l; ++i) {
+			b(i, i) = PsimagLite::real(b(i, i));
+			for (SizeType j = i + 1; j < l; ++j)
+				b(j, i) = PsimagLite::conj(b(i, j));
+		}
+
+		VectorRealType theta(l);
+		PsimagLite::diag(b, theta, 'V');
+
+		MatrixType ritz(n, l);
+		gemm('N', 'N', q, b, ritz);
+		MatrixType aRitz(n, l);
+		gemm('N', 'N', z, b, aRitz);
+
+		RealType captured = 0;
+		for (SizeType j = l - k; j < l; ++j)
+			captured += theta[j];
+
+		residual = trace() - captured;
+		if (residual < 0) residual = 0;
+
+		// ||a u - theta u|| for each Ritz pair kept
+		const RealType tolerance = 1e-9*trace();
+		for (SizeType j = l - k; j < l; ++j) {
+			RealType sum = 0;
+			for (SizeType i = 0; i < n; ++i) {
+				ComplexOrRealType tmp = aRitz(i, j) - theta[j]*ritz(i, j);
+				sum += PsimagLite::real(tmp*PsimagLite::conj(tmp));
+			}
+
+			if (sqrt(sum) > tolerance) return false;
+		}
+
+		u.clear();
+		u.resize(n, n);
+		u.setTo(0.0);
+		eigs.resize(n);
+		// states not computed share the residual evenly: their sum, and so
+		// the truncation error, is exact, but each value is a placeholder
+		SizeType notComputed = n - k;
+		for (SizeType j = 0; j < notComputed; ++j) {
+			u(j, j) = 1.0;
+			eigs[j] = residual/notComputed;
+		}
+
+		for (SizeType j = 0; j < k; ++j) {
+			SizeType jj = j + l - k;
+			for (SizeType i = 0; i < n; ++i)
+				u(i, j + notComputed) = ritz(i, jj);
+			eigs[j + notComputed] = theta[jj];
+		}
+
+		return true;
+	}
+
+	/* Blocks done partially whose weight not captured could reach the
+	   states kept are flagged in redo; a negative residual marks a block
+	   already fully diagonalized */
+	static SizeType borderline(VectorBoolType& redo,
+	                           const VectorRealType& eigs,
+	                           const VectorRealType& residuals,
+	                           SizeType kept)
+	{
+		redo.resize(residuals.size());
+		std::fill(redo.begin(), redo.end(), false);
+		if (kept == 0 || kept >= eigs.size()) return 0;
+
+		VectorRealType sorted = eigs;
+		std::nth_element(sorted.begin(),
+		                 sorted.begin() + kept - 1,
+		                 sorted.end(),
+		                 std::greater<RealType>());
+		RealType threshold = sorted[kept - 1];
+
+		SizeType count = 0;
+		for (SizeType i = 0; i < residuals.size(); ++i) {
+			if (residuals[i] < 0) continue;
+			if (2*residuals[i] < threshold) continue;
+			redo[i] = true;
+			++count;
+		}
+
+		return count;
+	}
+
+private:
+
+	RealType trace() const
+	{
+		RealType sum = 0;
+		if (isFactor_) {
+			for (SizeType j = 0; j < a_.cols(); ++j)
+				for (SizeType i = 0; i < a_.rows(); ++i)
+					sum += PsimagLite::real(a_(i, j)*PsimagLite::conj(a_(i, j)));
+		} else {
+			for (SizeType i = 0; i < a_.rows(); ++i)
+				sum += PsimagLite::real(a_(i, i));
+		}
+
+		return sum;
+	}
+
+	// y = rho*x
+	void apply(MatrixType& y, const MatrixType& x) const
+	{
+		y.clear();
+		y.resize(a_.rows(), x.cols());
+		if (!isFactor_) {
+			gemm('N', 'N', a_, x, y);
+			return;
+		}
+
+		MatrixType tmp(a_.cols(), x.cols());
+		gemm('C', 'N', a_, x, tmp);
+		gemm('N', 'N', a_, tmp, y);
+	}
+
+	// c = op(a)*b, with op(a) = a or a^dagger
+	static void gemm(char opA, char opB, const MatrixType& a, const MatrixType& b, MatrixType& c)
+	{
+		SizeType m = (opA == 'N') ? a.rows() : a.cols();
+		SizeType inner = (opA == 'N') ? a.cols() : a.rows();
+		assert(opB == 'N' && b.rows() == inner);
+		SizeType cols = b.cols();
+		assert(c.rows() == m && c.cols() == cols);
+		if (m == 0 || cols == 0) return;
+		if (inner == 0) {
+			c.setTo(0.0);
+			return;
+		}
+
+		psimag::BLAS::GEMM(opA,
+		                   opB,
+		                   m,
+		                   cols,
+		                   inner,
+		                   1.0,
+		                   &(a(0,0)),
+		                   a.rows(),
+		                   &(b(0,0)),
+		                   b.rows(),
+		                   0.0,
+		                   &(c(0,0)),
+		                   m);
+	}
+
+	// modified Gram-Schmidt, twice; a column that collapses, because rho has
+	// (numerically) fewer than l nonzero eigenvalues, is replaced by a random one
+	static bool orthonormalize(MatrixType& q, PsimagLite::Random48<RealType>& rng)
+	{
+		SizeType n = q.rows();
+		SizeType l = q.cols();
+		for (SizeType j = 0; j < l; ++j) {
+			RealType before = columnNorm(q, j);
+			RealType norma = project(q, j);
+			if (norma > 1e-12*before) {
+				scaleColumn(q, j, 1.0/norma);
+				continue;
+			}
+
+			for (SizeType p = 0; p < n; ++p)
+				q(p, j) = rng() - 0.5;
+			before = columnNorm(q, j);
+			norma = project(q, j);
+			if (norma < 1e-12*before) return false;
+			scaleColumn(q, j, 1.0/norma);
+		}
+
+		return true;
+	}
+
+	// removes from column j its components along the previous columns, twice
+	static RealType project(MatrixType& q, SizeType j)
+	{
+		SizeType n = q.rows();
+		for (SizeType pass = 0; pass < 2; ++pass) {
+			for (SizeType i = 0; i < j; ++i) {
+				ComplexOrRealType dot = 0;
+				for (SizeType p = 0; p < n; ++p)
+					dot += PsimagLite::conj(q(p, i))*q(p, j);
+				for (SizeType p = 0; p < n; ++p)
+					q(p, j) -= dot*q(p, i);
+			}
+		}
+
+		return columnNorm(q, j);
+	}
+
+	static RealType columnNorm(const MatrixType& q, SizeType j)
+	{
+		RealType sum = 0;
+		for (SizeType p = 0; p < q.rows(); ++p)
+			sum += PsimagLite::real(q(p, j)*PsimagLite::conj(q(p, j)));
+		return sqrt(sum);
+	}
+
+	static void scaleColumn(MatrixType& q, SizeType j, RealType factor)
+	{
+		for (SizeType p = 0; p < q.rows(); ++p)
+			q(p, j) *= factor;
+	}
+
+	const MatrixType& a_;
+	bool isFactor_;
+}; // class RandomizedEigs
+
+} // namespace Dmrg
+
+/*@}*/
+#endif // RANDOMIZED_EIGS_H
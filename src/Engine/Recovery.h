@@ -83,10 +83,16 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 #include "Vector.h"
 #include "ProgramGlobals.h"
 #include "ProgressIndicator.h"
+#include "IoThreads.h"
 #include <fstream>
+#include <cstdio>
 #include <sys/types.h>
 #include <dirent.h>
+#include <unistd.h>
 #include "Io/IoNg.h"
+#ifdef USE_PTHREADS
+#include <pthread.h>
+#endif
 
 namespace Dmrg {
 
@@ -116,6 +122,38 @@ class Recovery  {
 		SizeType stepCurrent;
 	};
 
+	// the stacks of a recovery file, possibly written by another thread;
+	// saved describes the stacks of the last recovery file
+	struct BackgroundWrite {
+
+		BackgroundWrite() : tag(0), running(false), done(false)
+		{
+#ifdef USE_PTHREADS
+			pthread_mutex_init(&mutex, 0);
+#endif
+		}
+
+		~BackgroundWrite()
+		{
+#ifdef USE_PTHREADS
+			pthread_mutex_destroy(&mutex);
+#endif
+		}
+
+		PsimagLite::String partialName;
+		PsimagLite::String savedName;
+		SizeType tag;
+		typename CheckpointType::StacksSnapshot snapshot;
+		typename CheckpointType::SavedEntries saved;
+		PsimagLite::String error;
+		bool running;
+		bool done;
+#ifdef USE_PTHREADS
+		pthread_t thread;
+		pthread_mutex_t mutex;
+#endif
+	};
+
 public:
 
 	enum {SYSTEM = ProgramGlobals::SYSTEM, ENVIRON = ProgramGlobals::ENVIRON};
@@ -142,6 +180,9 @@ public:
 	      wft_(wft),
 	      pS_(pS),
 	      pE_(pE),
+	      inBackground_(checkpoint.parameters().options.find("recoveryInBackground") !=
+	        PsimagLite::String::npos && IoThreads::enabled()),
+	      generation_(0),
 	      savedTime_(0),
 	      counter_(0)
 	{
@@ -162,11 +203,20 @@ public:
 
 	~Recovery()
 	{
+		try {
+			waitForBackgroundWrite();
+		} catch (std::exception& e) {
+			std::cerr<<e.what();
+		}
+
 		for (SizeType i = 0; i < MAX_RECOVERY_FILES; ++i) {
 			PsimagLite::String prefix(RecoveryStaticType::recoveryFilePrefix());
 			prefix += ttos(i);
 			PsimagLite::String savedName(prefix + checkpoint_.parameters().filename);
 			unlink(savedName.c_str());
+			PsimagLite::String partialName(RecoveryStaticType::partialFilePrefix() +
+			                               savedName);
+			unlink(partialName.c_str());
 		}
 	}
 
@@ -204,14 +254,23 @@ public:
 	           int lastSign,
 	           typename IoType::Out& ioOutCurrent) const
 	{
+		waitForBackgroundWrite();
+
 		PsimagLite::String prefix(RecoveryStaticType::recoveryFilePrefix());
 		prefix += ttos(counter_++);
 		PsimagLite::String savedName(prefix + checkpoint_.parameters().filename);
+		// written under another name and renamed when complete, so that
+		// an interrupted write never looks like a recovery file
+		PsimagLite::String partialName(RecoveryStaticType::partialFilePrefix() +
+		                               savedName);
 		ioOutCurrent.flush();
 
 		//copyFile(savedName.c_str(), ioOutCurrent.filename());
 
-		typename IoType::Out ioOut(savedName, IoType::ACC_TRUNC);
+		++generation_;
+		forgetEntriesIn(savedName);
+
+		typename IoType::Out ioOut(partialName, IoType::ACC_TRUNC);
 
 		writeEnergies(ioOut, ioOutCurrent.filename());
 
@@ -228,15 +287,137 @@ public:
 
 		ioOut.close();
 
-		// checkpoint stacks
-		checkpoint_.checkpointStacks(savedName);
+		// checkpoint stacks, only the entries not in earlier files
+		writeStacks(partialName, savedName);
 
 		if (counter_ >= checkpoint_.parameters().recoveryMaxFiles ||
 		        counter_ >= MAX_RECOVERY_FILES) counter_ = 0;
 	}
 
+	// finishes the background write if it is done, without waiting
+	void collectBackgroundWrite() const
+	{
+		if (!background_.running) return;
+
+#ifdef USE_PTHREADS
+		pthread_mutex_lock(&background_.mutex);
+		bool done = background_.done;
+		pthread_mutex_unlock(&background_.mutex);
+		if (!done) return;
+#endif
+
+		waitForBackgroundWrite();
+	}
+
 private:
 
+	// the stacks are taken as a snapshot, so that with recoveryInBackground
+	// the sweep can go on
+	void writeStacks(PsimagLite::String partialName,
+	                 PsimagLite::String savedName) const
+	{
+		background_.partialName = partialName;
+		background_.savedName = savedName;
+		background_.tag = generation_;
+		background_.error = "";
+		background_.done = false;
+		checkpoint_.snapshotStacks(background_.snapshot);
+
+#ifdef USE_PTHREADS
+		if (inBackground_ &&
+		        pthread_create(&background_.thread, 0, writeInBackground, &background_) == 0) {
+			background_.running = true;
+			return;
+		}
+#endif
+
+		writeInBackground(&background_);
+		finishBackgroundWrite();
+	}
+
+	static void* writeInBackground(void* arg)
+	{
+		BackgroundWrite* bw = static_cast<BackgroundWrite*>(arg);
+		PsimagLite::String error("");
+		try {
+			CheckpointType::writeSnapshot(bw->partialName,
+			                              bw->savedName,
+			                              bw->tag,
+			                              bw->snapshot,
+			                              bw->saved);
+			commitFile(bw->partialName, bw->savedName);
+		} catch (std::exception& e) {
+			error = e.what();
+		}
+
+#ifdef USE_PTHREADS
+		pthread_mutex_lock(&bw->mutex);
+#endif
+		bw->error = error;
+		bw->done = true;
+#ifdef USE_PTHREADS
+		pthread_mutex_unlock(&bw->mutex);
+#endif
+		return 0;
+	}
+
+	void waitForBackgroundWrite() const
+	{
+		if (!background_.running) return;
+
+#ifdef USE_PTHREADS
+		pthread_join(background_.thread, 0);
+#endif
+
+		background_.running = false;
+		finishBackgroundWrite();
+	}
+
+	void finishBackgroundWrite() const
+	{
+		if (background_.error == "") {
+			PsimagLite::OstringStream msg;
+			msg<<"Stacks saved: system "<<background_.saved.systemWritten;
+			msg<<" of "<<background_.snapshot.system.entries.size();
+			msg<<", environ "<<background_.saved.environmentWritten;
+			msg<<" of "<<background_.snapshot.environment.entries.size();
+			msg<<" entries; the others are references";
+			progress_.printline(msg, std::cout);
+		}
+
+		checkpoint_.releaseSnapshot(background_.snapshot);
+
+		if (background_.error == "") return;
+
+		PsimagLite::String msg("Recovery: writing " + background_.savedName);
+		err(msg + " failed: " + background_.error + "\n");
+	}
+
+	// file is about to be replaced; its entries will be written again
+	void forgetEntriesIn(PsimagLite::String file) const
+	{
+		forgetEntriesIn(background_.saved.system, file);
+		forgetEntriesIn(background_.saved.environment, file);
+	}
+
+	static void forgetEntriesIn(typename CheckpointType::MapSavedEntryType& saved,
+	                            PsimagLite::String file)
+	{
+		typename CheckpointType::MapSavedEntryType::iterator it = saved.begin();
+		while (it != saved.end()) {
+			if (it->second.file == file) saved.erase(it++);
+			else ++it;
+		}
+	}
+
+	static void commitFile(PsimagLite::String partialName,
+	                       PsimagLite::String savedName)
+	{
+		if (rename(partialName.c_str(), savedName.c_str()) == 0) return;
+
+		err("Recovery: cannot rename " + partialName + " to " + savedName + "\n");
+	}
+
 	void procOptions()
 	{
 		PsimagLite::String str = checkpoint_.parameters().recoverySave;
@@ -293,6 +474,7 @@ private:
 
 		ioOut.write(loopIndex, "Recovery/loopIndex")	;
 		ioOut.write(stepCurrent, "Recovery/stepCurrent");
+		ioOut.write(generation_, "Recovery/generation");
 	}
 
 	void readRecovery()
@@ -301,6 +483,10 @@ private:
 
 		ioIn2.read(opaqueRestart_.loopIndex, "Recovery/loopIndex");
 		ioIn2.read(opaqueRestart_.stepCurrent, "Recovery/stepCurrent");
+		try {
+			ioIn2.read(generation_, "Recovery/generation");
+		} catch (...) {}
+
 		ioIn2.close();
 	}
 
@@ -365,6 +551,9 @@ private:
 	const WaveFunctionTransfType& wft_;
 	const BasisWithOperatorsType& pS_;
 	const BasisWithOperatorsType& pE_;
+	bool inBackground_;
+	mutable SizeType generation_;
+	mutable BackgroundWrite background_;
 	mutable SizeType savedTime_;
 	mutable SizeType counter_;
 }; //class Recovery
@@ -376,6 +565,8 @@ public:
 
 	static PsimagLite::String recoveryFilePrefix() { return "Recovery"; }
 
+	static PsimagLite::String partialFilePrefix() { return "Partial"; }
+
 	// this function is called before the ctor
 	static void autoRestart(ParametersType& params)
 	{
@@ -451,32 +642,46 @@ private:
 		if (files.size() == 0) return "";
 
 		PsimagLite::String saved("");
+		SizeType maxGeneration = 0;
 		SizeType max = 0;
 
+		// counters wrap around, so the newest file is the one with the
+		// largest generation; files written without one have generation 0
 		for (SizeType i = 0; i < files.size(); ++i) {
 			std::vector<PsimagLite::String> parts;
 			makeThreeParts(parts, files[i]);
 			if (parts.size() != 3 || parts[0] != prefix || parts[2] != filename)
 				continue;
 			SizeType counter = atoi(parts[1].c_str());
-			if (counter >= max && isValidFile(files[i])) {
-				max = counter;
-				saved = files[i];
-			}
+			SizeType generation = 0;
+			if (!isValidFile(files[i], generation)) continue;
+			if (generation < maxGeneration) continue;
+			if (generation == maxGeneration && counter < max) continue;
+			maxGeneration = generation;
+			max = counter;
+			saved = files[i];
 		}
 
 		return saved;
 	}
 
-	static bool isValidFile(PsimagLite::String file)
+	// valid if readable and every file its stacks refer to is still
+	// the one that was referenced
+	static bool isValidFile(PsimagLite::String file, SizeType& generation)
 	{
 		try {
 			PsimagLite::IoNg::In ioIn(file);
+			try {
+				ioIn.read(generation, "Recovery/generation");
+			} catch (...) {}
+
 			ioIn.close();
-			return true;
-		} catch (...) {}
+		} catch (...) {
+			return false;
+		}
 
-		return false;
+		return (DiskStackReferences::valid(file, "system") &&
+		        DiskStackReferences::valid(file, "environ"));
 	}
 };
 } // namespace Dmrg
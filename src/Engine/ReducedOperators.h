@@ -84,6 +84,7 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 #include "ChangeOfBasis.h"
 #include "BlockOffDiagMatrix.h"
 #include "../KronUtil/MatrixDenseOrSparse.h"
+#include <algorithm>
 
 namespace Dmrg {
 template<typename BasisType>
@@ -106,6 +107,44 @@ class ReducedOperators {
 	typedef typename PsimagLite::Vector<SizeType>::Type VectorSizeType;
 	typedef ChangeOfBasis<SparseMatrixType, DenseMatrixType> ChangeOfBasisType;
 
+	// dense table of indices, row major, that swap() exchanges without copies
+	template<typename T>
+	class IndexTable {
+
+	public:
+
+		IndexTable() : cols_(0) {}
+
+		void resize(SizeType rows, SizeType cols, T value = T())
+		{
+			data_.assign(rows*cols, value);
+			cols_ = cols;
+		}
+
+		T& operator()(SizeType i, SizeType j)
+		{
+			assert(j < cols_ && i*cols_ + j < data_.size());
+			return data_[i*cols_ + j];
+		}
+
+		const T& operator()(SizeType i, SizeType j) const
+		{
+			assert(j < cols_ && i*cols_ + j < data_.size());
+			return data_[i*cols_ + j];
+		}
+
+		void swap(IndexTable& other)
+		{
+			data_.swap(other.data_);
+			std::swap(cols_, other.cols_);
+		}
+
+	private:
+
+		typename PsimagLite::Vector<T>::Type data_;
+		SizeType cols_;
+	};
+
 public:
 
 	typedef typename ChangeOfBasisType::BlockDiagonalMatrixType BlockDiagonalMatrixType;
@@ -310,7 +349,9 @@ public:
 	                            const BlockDiagonalMatrixType& transform)
 	{
 		hamiltonian.checkValidity();
-		ChangeOfBasisType::changeBasis(hamiltonian,transform);
+		ChangeOfBasisType::changeBasis(hamiltonian,
+		                               transform,
+		                               PsimagLite::Concurrency::codeSectionParams.npthreads);
 		if (useSu2Symmetry_)
 			changeBasis(reducedHamiltonian_);
 	}
@@ -411,6 +452,28 @@ public:
 		io.write(reducedOperators_,"Operators");
 	}
 
+	// thisBasis_ is not exchanged: each object keeps pointing to its own basis
+	void swap(ReducedOperators& other)
+	{
+		momentumOfOperators_.swap(other.momentumOfOperators_);
+		basisrinverse_.swap(other.basisrinverse_);
+		reducedOperators_.swap(other.reducedOperators_);
+		reducedHamiltonian_.swap(other.reducedHamiltonian_);
+		std::swap(j1Max_, other.j1Max_);
+		std::swap(j2Max_, other.j2Max_);
+		lfactorLeft_.swap(other.lfactorLeft_);
+		lfactorRight_.swap(other.lfactorRight_);
+		lfactorHamLeft_.swap(other.lfactorHamLeft_);
+		lfactorHamRight_.swap(other.lfactorHamRight_);
+		reducedMapping_.swap(other.reducedMapping_);
+		fastBasisLeft_.swap(other.fastBasisLeft_);
+		fastBasisRight_.swap(other.fastBasisRight_);
+		flavorIndexCached_.swap(other.flavorIndexCached_);
+		changeOfBasis_.swap(other.changeOfBasis_);
+		su2Transform_.swap(other.su2Transform_);
+		su2TransformT_.swap(other.su2TransformT_);
+	}
+
 	template<typename IoOutputter>
 	void saveEmpty(IoOutputter& io,const PsimagLite::String&) const
 	{
@@ -418,10 +481,10 @@ public:
 		io.write(tmp,"Operators");
 	}
 
-	void changeBasis(SparseMatrixType &v)
+	void changeBasis(SparseMatrixType &v, SizeType threads = 1)
 	{
 		if (!useSu2Symmetry_)
-			return changeOfBasis_(v);
+			return changeOfBasis_(v, threads);
 
 		SparseMatrixType tmp;
 		multiply(tmp,v,su2Transform_);
@@ -897,10 +960,10 @@ private:
 	VectorVectorType lfactorLeft_;
 	VectorVectorType lfactorRight_;
 	VectorType lfactorHamLeft_,lfactorHamRight_;
-	PsimagLite::Matrix<int> reducedMapping_;
+	IndexTable<int> reducedMapping_;
 	PsimagLite::Vector<PsimagLite::Vector<SizeType>::Type>::Type fastBasisLeft_;
 	PsimagLite::Vector<PsimagLite::Vector<SizeType>::Type>::Type fastBasisRight_;
-	PsimagLite::Matrix<SizeType> flavorIndexCached_;
+	IndexTable<SizeType> flavorIndexCached_;
 	ChangeOfBasisType changeOfBasis_;
 	SparseMatrixType su2Transform_;
 	SparseMatrixType su2TransformT_;
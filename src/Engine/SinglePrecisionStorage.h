@@ -0,0 +1,224 @@
+/*
+Copyright (c) 2009-2019, UT-Battelle, LLC
+All rights reserved
+
+[DMRG++, Version 5.]
+[by G.A., Oak Ridge National Laboratory]
+
+UT Battelle Open Source Software License 11242008
+
+OPEN SOURCE LICENSE
+
+Subject to the conditions of this License, each
+contributor to this software hereby grants, free of
+charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), a
+perpetual, worldwide, non-exclusive, no-charge,
+royalty-free, irrevocable copyright license to use, copy,
+modify, merge, publish, distribute, and/or sublicense
+copies of the Software.
+
+1. Redistributions of Software must retain the above
+copyright and license notices, this list of conditions,
+and the following disclaimer.  Changes or modifications
+to, or derivative works of, the Software should be noted
+with comments and the contributor and organization's
+name.
+
+2. Neither the names of UT-Battelle, LLC or the
+Department of Energy nor the names of the Software
+contributors may be used to endorse or promote products
+derived from this software without specific prior written
+permission of UT-Battelle.
+
+3. The software and the end-user documentation included
+with the redistribution, with or without modification,
+must include the following acknowledgment:
+
+"This product includes software produced by UT-Battelle,
+LLC under Contract No. DE-AC05-00OR22725  with the
+Department of Energy."
+
+*********************************************************
+DISCLAIMER
+
+THE SOFTWARE IS SUPPLIED BY THE COPYRIGHT HOLDERS AND
+CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER, CONTRIBUTORS, UNITED STATES GOVERNMENT,
+OR THE UNITED STATES DEPARTMENT OF ENERGY BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+DAMAGE.
+
+NEITHER THE UNITED STATES GOVERNMENT, NOR THE UNITED
+STATES DEPARTMENT OF ENERGY, NOR THE COPYRIGHT OWNER, NOR
+ANY OF THEIR EMPLOYEES, REPRESENTS THAT THE USE OF ANY
+INFORMATION, DATA, APPARATUS, PRODUCT, OR PROCESS
+DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
+
+*********************************************************
+*/
+
+/** \ingroup DMRG */
+/*@{*/
+
+/*! \file SinglePrecisionStorage.h
+ *
+ *  Saves a sparse matrix with its values in single precision, and
+ *  reads it back promoted to the precision of the matrix
+ */
+
+#ifndef DMRG_SINGLE_PRECISION_STORAGE_H
+#define DMRG_SINGLE_PRECISION_STORAGE_H
+#include "Vector.h"
+#include "CrsMatrix.h"
+#include "Complex.h"
+#include "Checksum.h"
+
+namespace Dmrg {
+
+template<typename SparseMatrixType>
+class SinglePrecisionStorage {
+
+	typedef typename SparseMatrixType::value_type ComplexOrRealType;
+	typedef typename PsimagLite::Real<ComplexOrRealType>::Type RealType;
+	typedef PsimagLite::Vector<float>::Type VectorFloatType;
+	typedef PsimagLite::Vector<SizeType>::Type VectorSizeType;
+
+	// floats per value
+	enum {COMPONENTS = (PsimagLite::IsComplexNumber<ComplexOrRealType>::True) ? 2 : 1};
+
+public:
+
+	template<typename SomeIoOutType>
+	static void write(SomeIoOutType& io,
+	                  const PsimagLite::String& label,
+	                  const SparseMatrixType& m)
+	{
+		SizeType rows = m.rows();
+		SizeType nonZeros = m.nonZeros();
+		VectorSizeType rowPtr(rows + 1);
+		for (SizeType i = 0; i <= rows; ++i)
+			rowPtr[i] = m.getRowPtr(i);
+
+		VectorSizeType cols(nonZeros);
+		VectorFloatType values(nonZeros*COMPONENTS);
+		for (SizeType k = 0; k < nonZeros; ++k) {
+			cols[k] = m.getCol(k);
+			split(values, k, m.getValue(k));
+		}
+
+		io.createGroup(label);
+		io.write(rows, label + "/Rows");
+		io.write(m.cols(), label + "/Cols");
+		io.write(rowPtr, label + "/RowPtr");
+		if (nonZeros == 0) return;
+
+		io.write(cols, label + "/ColIndices");
+		io.write(values, label + "/Values");
+	}
+
+	template<typename SomeIoInType>
+	static void read(SparseMatrixType& m,
+	                 SomeIoInType& io,
+	                 const PsimagLite::String& label)
+	{
+		SizeType rows = 0;
+		SizeType ncols = 0;
+		VectorSizeType rowPtr;
+		io.read(rows, label + "/Rows");
+		io.read(ncols, label + "/Cols");
+		io.read(rowPtr, label + "/RowPtr");
+		if (rowPtr.size() != rows + 1)
+			err("SinglePrecisionStorage: wrong RowPtr in " + label + "\n");
+
+		SizeType nonZeros = rowPtr[rows];
+		VectorSizeType cols;
+		VectorFloatType values;
+		if (nonZeros > 0) {
+			io.read(cols, label + "/ColIndices");
+			io.read(values, label + "/Values");
+		}
+
+		if (cols.size() != nonZeros || values.size() != nonZeros*COMPONENTS)
+			err("SinglePrecisionStorage: wrong number of values in " + label + "\n");
+
+		SparseMatrixType tmp(rows, ncols, nonZeros);
+		for (SizeType i = 0; i < rows; ++i) {
+			tmp.setRow(i, rowPtr[i]);
+			for (SizeType k = rowPtr[i]; k < rowPtr[i + 1]; ++k) {
+				ComplexOrRealType value = 0.0;
+				join(value, values, k);
+				tmp.setCol(k, cols[k]);
+				tmp.setValues(k, value);
+			}
+		}
+
+		tmp.setRow(rows, nonZeros);
+		tmp.checkValidity();
+		m.swap(tmp);
+	}
+
+	// as Checksum::add(m), with the values that read() will give back
+	static void addTo(Checksum& sum, const SparseMatrixType& m)
+	{
+		SizeType rows = m.rows();
+		sum.add(rows);
+		sum.add(m.cols());
+		for (SizeType i = 0; i <= rows; ++i)
+			sum.add(m.getRowPtr(i));
+
+		SizeType nonZeros = m.nonZeros();
+		for (SizeType k = 0; k < nonZeros; ++k) {
+			sum.add(m.getCol(k));
+			sum.add(rounded(m.getValue(k)));
+		}
+	}
+
+private:
+
+	static void split(VectorFloatType& v, SizeType k, const RealType& x)
+	{
+		v[k] = x;
+	}
+
+	static void split(VectorFloatType& v, SizeType k, const std::complex<RealType>& x)
+	{
+		v[2*k] = PsimagLite::real(x);
+		v[2*k + 1] = PsimagLite::imag(x);
+	}
+
+	static void join(RealType& x, const VectorFloatType& v, SizeType k)
+	{
+		x = v[k];
+	}
+
+	static void join(std::complex<RealType>& x, const VectorFloatType& v, SizeType k)
+	{
+		x = std::complex<RealType>(v[2*k], v[2*k + 1]);
+	}
+
+	static RealType rounded(const RealType& x)
+	{
+		return static_cast<float>(x);
+	}
+
+	static std::complex<RealType> rounded(const std::complex<RealType>& x)
+	{
+		return std::complex<RealType>(static_cast<float>(PsimagLite::real(x)),
+		                              static_cast<float>(PsimagLite::imag(x)));
+	}
+}; // class SinglePrecisionStorage
+} // namespace Dmrg
+
+/*@}*/
+#endif
@@ -224,6 +224,17 @@ public:
 
 	const LeftRightSuperType& lrs() const { return lrs_; }
 
+	void setWriteQueue(typename TargetingCommonType::IoWriteQueueType* writeQueue)
+	{
+		commonTargeting_.setWriteQueue(writeQueue);
+	}
+
+	// group of the target for the counter-th output step
+	static PsimagLite::String prefixFor(SizeType counter)
+	{
+		return "TargetingCommon/" + ttos(counter);
+	}
+
 	static PsimagLite::String buildPrefix(PsimagLite::IoSelector::Out& io,
 	                                      SizeType counter)
 	{
@@ -236,7 +247,7 @@ public:
 		         (counter == 0) ? SerializerType::NO_OVERWRITE :
 		                          SerializerType::ALLOW_OVERWRITE);
 
-		prefix += ("/" + ttos(counter));
+		prefix = prefixFor(counter);
 
 		io.createGroup(prefix);
 		return prefix;
@@ -91,6 +91,7 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 #include "ApplyOperatorExpression.h"
 #include "Io/IoSelector.h"
 #include "PsimagLite.h"
+#include "IoWriteQueue.h"
 
 namespace Dmrg {
 
@@ -136,6 +137,7 @@ public:
 	typedef typename ApplyOperatorExpressionType::PairType PairType;
 	typedef typename ModelType::InputValidatorType InputValidatorType;
 	typedef Braket<ModelType> BraketType;
+	typedef IoWriteQueue<PsimagLite::IoSelector::Out> IoWriteQueueType;
 
 	static const SizeType SUM = TargetParamsType::SUM;
 
@@ -150,7 +152,8 @@ public:
 	    : progress_("TargetingCommon"),
 	      targetHelper_(lrs,model,wft),
 	      applyOpExpression_(targetHelper_,indexNoAdvance),
-	      inSitu_(model.geometry().numberOfSites())
+	      inSitu_(model.geometry().numberOfSites()),
+	      writeQueue_(0)
 	{}
 
 	void init(TargetParamsType* tstStruct, SizeType targets)
@@ -231,6 +234,12 @@ public:
 		msg<<"Saving state...";
 		progress_.printline(msg,std::cout);
 
+		if (queued(io)) {
+			writeQueue_->write(block[0], prefix + "/TargetCentralSite");
+			writeQueue_->writeObject(new VectorWithOffsetType(psi()), prefix + "/PSI");
+			return;
+		}
+
 		io.write(block[0], prefix + "/TargetCentralSite");
 		psi().write(io, prefix + "/PSI");
 	}
@@ -240,6 +249,7 @@ public:
 	                PsimagLite::String prefix,
 	                const PostProcType& cf) const
 	{
+		if (queued(io)) writeQueue_->drain();
 		cf.write(io, prefix);
 		writeNGSTs(io, block, prefix);
 	}
@@ -250,6 +260,15 @@ public:
 	{
 		SizeType marker = (noStageIs(DISABLED)) ? 1 : 0;
 		SizeType size = block[0];
+		if (queued(io)) {
+			TimeSerializerType* ts = new TimeSerializerType(currentTime(),
+			                                                size,
+			                                                applyOpExpression_.targetVectors(),
+			                                                marker);
+			writeQueue_->writeObject(ts, prefix);
+			return;
+		}
+
 		TimeSerializerType ts(currentTime(),
 		                      size,
 		                      applyOpExpression_.targetVectors(),
@@ -257,6 +276,12 @@ public:
 		ts.write(io, prefix);
 	}
 
+	// output to the queue's file goes through the queue from now on
+	void setWriteQueue(IoWriteQueueType* writeQueue)
+	{
+		writeQueue_ = writeQueue;
+	}
+
 	void read(IoInputType& io,
 	          PsimagLite::String prefix)
 	{
@@ -626,6 +651,11 @@ public:
 
 private:
 
+	bool queued(const PsimagLite::IoSelector::Out& io) const
+	{
+		return (writeQueue_ && writeQueue_->inBackground() && writeQueue_->isFor(io));
+	}
+
 	void setQuantumNumbers(const VectorWithOffsetType& v)
 	{
 		applyOpExpression_.setQuantumNumbers(v);
@@ -778,6 +808,7 @@ private:
 	TargetHelperType targetHelper_;
 	ApplyOperatorExpressionType applyOpExpression_;
 	mutable VectorType inSitu_;
+	IoWriteQueueType* writeQueue_;
 }; // class TargetingCommon
 
 template<typename TargetHelperType,
@@ -85,6 +85,7 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 #include "Sort.h"
 #include "Concurrency.h"
 #include "Io/IoNg.h"
+#include "IoWriteQueue.h"
 
 namespace Dmrg {
 
@@ -116,6 +117,7 @@ public:
 	typedef typename DensityMatrixBaseType::Params ParamsDensityMatrixType;
 	typedef BlockDiagonalMatrixType TransformType;
 	typedef PsimagLite::IoNg::Out IoOutType;
+	typedef IoWriteQueue<IoOutType> IoWriteQueueType;
 
 	struct TruncationCache {
 
@@ -129,7 +131,7 @@ public:
 	           WaveFunctionTransfType& waveFunctionTransformation,
 	           const ParametersType& parameters,
 	           const GeometryType& geometry,
-	           IoOutType& ioOut)
+	           IoWriteQueueType& ioOut)
 	    : reflectionOperator_(reflectionOperator),
 	      lrs_(reflectionOperator_.leftRightSuper()),
 	      waveFunctionTransformation_(waveFunctionTransformation),
@@ -212,7 +214,9 @@ private:
 
 		bool debug = false;
 		bool useSvd = (parameters_.options.find("truncationNoSvd") == PsimagLite::String::npos);
-		ParamsDensityMatrixType p(useSvd, direction, debug);
+		bool partial = (parameters_.options.find("truncationRandomized") !=
+		        PsimagLite::String::npos);
+		ParamsDensityMatrixType p(useSvd, direction, debug, (partial) ? keptStates : 0);
 		TruncationCache& cache = (direction == ProgramGlobals::EXPAND_SYSTEM) ?
 		            leftCache_ : rightCache_;
 		DensityMatrixBaseType* dmS = 0;
@@ -223,6 +227,8 @@ private:
 				p.useSvd = false;
 			}
 
+			p.partialKept = 0;
+
 			dmS = new DensityMatrixSu2Type(target,lrs_,p);
 		} else if (p.useSvd) {
 			dmS = new DensityMatrixSvdType(target,lrs_,p);
@@ -277,7 +283,8 @@ private:
 		rSprime.truncateBasis(cache.transform,
 		                      cache.eigs,
 		                      cache.removedIndices,
-		                      startEnd);
+		                      startEnd,
+		                      parameters_.operatorsDropTolerance);
 		LeftRightSuperType lrs(rSprime,(BasisWithOperatorsType&) eBasis,
 		                       (BasisType&)lrs_.super());
 		bool twoSiteDmrg = waveFunctionTransformation_.options().twoSiteDmrg;
@@ -315,7 +322,8 @@ private:
 		rEprime.truncateBasis(cache.transform,
 		                      cache.eigs,
 		                      cache.removedIndices,
-		                      startEnd);
+		                      startEnd,
+		                      parameters_.operatorsDropTolerance);
 		LeftRightSuperType lrs((BasisWithOperatorsType&) sBasis,
 		                       rEprime,(BasisType&)lrs_.super());
 		bool twoSiteDmrg = waveFunctionTransformation_.options().twoSiteDmrg;
@@ -506,7 +514,7 @@ private:
 	WaveFunctionTransfType& waveFunctionTransformation_;
 	const ParametersType& parameters_;
 	const GeometryType& geometry_;
-	IoOutType& ioOut_;
+	IoWriteQueueType& ioOut_;
 	ProgressIndicatorType progress_;
 	RealType error_;
 	TruncationCache leftCache_;
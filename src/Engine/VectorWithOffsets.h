@@ -84,7 +84,9 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 #include "ProgressIndicator.h"
 #include <cassert>
 #include "ProgramGlobals.h"
+#include "Checksum.h"
 #include <typeinfo>
+#include <algorithm>
 
 // FIXME: a more generic solution is needed instead of tying
 // the non-zero structure to basis
@@ -97,6 +99,8 @@ class VectorWithOffsets {
 	typedef typename QnType_::PairSizeType PairSizeType;
 
 	static ComplexOrRealType const zero_;
+	// 0 had index2Sector_, as long as the vector
+	static const SizeType FORMAT_VERSION = 1;
 
 public:
 
@@ -107,7 +111,7 @@ public:
 	typedef typename PsimagLite::Vector<ComplexOrRealType>::Type VectorType;
 
 	VectorWithOffsets()
-	    : progress_("VectorWithOffsets"),size_(0),index2Sector_(0)
+	    : progress_("VectorWithOffsets"),size_(0)
 	{ }
 
 	template<typename SomeBasisType>
@@ -115,7 +119,6 @@ public:
 	                  const SomeBasisType& someBasis)
 	    : progress_("VectorWithOffsets"),
 	      size_(someBasis.size()),
-	      index2Sector_(size_),
 	      data_(weights.size()),
 	      offsets_(weights.size()+1)
 	{
@@ -130,16 +133,16 @@ public:
 		}
 
 		offsets_[weights.size()]=size_;
-		setIndex2Sector();
+		setNonZeroSectors();
 	}
 
 	void resize(SizeType x)
 	{
 		size_ = x;
-		index2Sector_.resize(x);
 		data_.clear();
 		offsets_.clear();
 		nzMsAndQns_.clear();
+		nonZeroSector_.clear();
 	}
 
 	template<typename SomeBasisType>
@@ -161,7 +164,7 @@ public:
 		}
 
 		offsets_[v.size()]=size_;
-		setIndex2Sector();
+		setNonZeroSectors();
 	}
 
 	template<typename SomeBasisType>
@@ -183,7 +186,7 @@ public:
 		}
 
 		offsets_[np]=size_;
-		setIndex2Sector();
+		setNonZeroSectors();
 		PsimagLite::OstringStream msg;
 		msg<<"Populated "<<np<<" sectors";
 		progress_.printline(msg,std::cout);
@@ -215,7 +218,7 @@ public:
 			nzMsAndQns_.push_back(PairQnType(ip, v.qn(i)));
 		}
 
-		setIndex2Sector();
+		setNonZeroSectors();
 		PsimagLite::OstringStream msg;
 		msg<<"populateFromQns "<<v.sectors()<<" sectors";
 		progress_.printline(msg,std::cout);
@@ -240,7 +243,7 @@ public:
 		}
 
 		nzMsAndQns_ = nzMsAndQns;
-		setIndex2Sector();
+		setNonZeroSectors();
 		PsimagLite::OstringStream msg;
 		msg<<"Collapsed. Non-zero sectors now are "<<nzMsAndQns_.size();
 		progress_.printline(msg,std::cout);
@@ -293,7 +296,7 @@ public:
 				data_[j][i] = v[i+offset];
 		}
 
-		setIndex2Sector();
+		setNonZeroSectors();
 	}
 
 	void extract(VectorType& v,SizeType i) const
@@ -337,15 +340,15 @@ public:
 
 	const ComplexOrRealType& slowAccess(SizeType i) const
 	{
-		assert(i<index2Sector_.size());
-		int j = index2Sector_[i];
+		assert(i<size_);
+		int j = index2Sector(i);
 		if (j<0) return zero_;
 		return data_[j][i-offsets_[j]];
 	}
 
 	ComplexOrRealType& slowAccess(SizeType i)
 	{
-		int j = index2Sector_[i];
+		int j = index2Sector(i);
 		if (j<0) {
 			PsimagLite::String msg("VectorWithOffsets");
 			std::cerr<<msg<<" can't build itself dynamically yet (sorry!)\n";
@@ -373,8 +376,16 @@ public:
 	void read(SomeInputType& io,
 	          PsimagLite::String label)
 	{
+		SizeType version = 0;
+		try {
+			io.read(version, label + "/version");
+		} catch (...) {}
+
+		if (version > FORMAT_VERSION)
+			err("VectorWithOffsets: " + label + " has an unknown format version\n");
+
+		// version 0 also has index2Sector_, which is not needed
 		io.read(size_, label + "/size_");
-		io.read(index2Sector_, label + "/index2Sector_");
 		SizeType x = 0;
 		io.read(x, label + "/data_/Size");
 		data_.resize(x);
@@ -398,18 +409,41 @@ public:
 			io.read(nzMsAndQns_[i].first, label + "/nzMsAndQns_/" + ttos(i) + "/0");
 			nzMsAndQns_[i].second.read(label + "/nzMsAndQns_/" + ttos(i) + "/1", io);
 		}
+
+		setNonZeroSectors();
+
+		SizeType stored = 0;
+		try {
+			io.read(stored, label + "/checksum");
+		} catch (...) {
+			return; // saved before checksums existed
+		}
+
+		if (stored != checksum())
+			err("VectorWithOffsets: checksum mismatch reading " + label + "\n");
 	}
 
 	template<typename SomeIoOutputType>
 	void write(SomeIoOutputType& io,
 	          const PsimagLite::String& label) const
 	{
+		SizeType version = FORMAT_VERSION;
 		io.createGroup(label);
+		io.write(version, label + "/version");
 		io.write(size_, label + "/size_");
-		io.write(index2Sector_, label + "/index2Sector_");
 		io.write(data_, label + "/data_");
 		io.write(offsets_, label + "/offsets_");
 		io.write(nzMsAndQns_, label + "/nzMsAndQns_");
+		io.write(checksum(), label + "/checksum");
+	}
+
+	SizeType checksum() const
+	{
+		Checksum sum;
+		sum.add(size_);
+		sum.add(data_);
+		sum.add(offsets_);
+		return sum.value();
 	}
 
 	// We don't have a partitioned basis because we don't
@@ -454,7 +488,7 @@ public:
 			io.read(data_[x], s);
 		}
 
-		setIndex2Sector();
+		setNonZeroSectors();
 	}
 
 	VectorWithOffsets operator+=(const VectorWithOffsets& v)
@@ -464,7 +498,7 @@ public:
 			data_ = v.data_;
 			offsets_ = v.offsets_;
 			nzMsAndQns_ = v.nzMsAndQns_;
-			setIndex2Sector();
+			setNonZeroSectors();
 			return *this;
 		}
 
@@ -474,14 +508,23 @@ public:
 			data_[i] += v.data_[i];
 		}
 
-		setIndex2Sector();
+		setNonZeroSectors();
 		return *this;
 	}
 
+	// sector that has index i, or -1 if that sector is zero
 	int index2Sector(SizeType i) const
 	{
-		assert(i < index2Sector_.size());
-		return index2Sector_[i];
+		assert(i < size_);
+		if (offsets_.size() < 2) return -1;
+
+		typename PsimagLite::Vector<SizeType>::Type::const_iterator it =
+		        std::upper_bound(offsets_.begin(), offsets_.end(), i);
+		if (it == offsets_.begin() || it == offsets_.end()) return -1;
+
+		SizeType j = it - offsets_.begin() - 1;
+		assert(j < nonZeroSector_.size());
+		return (nonZeroSector_[j]) ? j : -1;
 	}
 
 	friend RealType norm(const VectorWithOffsets& v)
@@ -567,20 +610,16 @@ public:
 
 private:
 
-	void setIndex2Sector()
+	// one flag per sector; index2Sector() finds the sector of an index
+	// by bisection of offsets_
+	void setNonZeroSectors()
 	{
-		if (index2Sector_.size()!=size_)
-			index2Sector_.resize(size_);
-
-		for (SizeType i = 0; i < size_; ++i) {
-			index2Sector_[i] = -1;
-			for (SizeType jj = 0; jj < nzMsAndQns_.size(); ++jj) {
-				SizeType j = nzMsAndQns_[jj].first;
-				assert(j + 1 < offsets_.size());
-				if (i < offsets_[j] || i >= offsets_[j+1])
-					continue;
-				index2Sector_[i] = j;
-			}
+		SizeType n = (offsets_.size() > 0) ? offsets_.size() - 1 : 0;
+		nonZeroSector_.assign(n, false);
+		for (SizeType jj = 0; jj < nzMsAndQns_.size(); ++jj) {
+			SizeType j = nzMsAndQns_[jj].first;
+			assert(j < n);
+			nonZeroSector_[j] = true;
 		}
 	}
 
@@ -642,10 +681,10 @@ private:
 
 	PsimagLite::ProgressIndicator progress_;
 	SizeType size_;
-	typename PsimagLite::Vector<int>::Type index2Sector_;
 	typename PsimagLite::Vector<VectorType>::Type data_;
 	typename PsimagLite::Vector<SizeType>::Type offsets_;
 	typename PsimagLite::Vector<PairQnType>::Type nzMsAndQns_;
+	PsimagLite::Vector<bool>::Type nonZeroSector_;
 }; // class VectorWithOffset
 
 template<typename ComplexOrRealType, typename EffectiveQnType>
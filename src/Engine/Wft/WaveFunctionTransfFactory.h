@@ -85,9 +85,11 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 #include "ProgressIndicator.h"
 #include "WaveFunctionTransfLocal.h"
 #include "WaveFunctionTransfSu2.h"
+#include "WftInfinite.h"
 #include "DmrgWaveStruct.h"
 #include "Io/IoSelector.h"
 #include "Random48.h"
+#include "OutOfCoreStack.h"
 
 namespace Dmrg {
 template<typename LeftRightSuperType,typename VectorWithOffsetType_>
@@ -116,7 +118,9 @@ public:
 	typedef WaveFunctionTransfSu2<DmrgWaveStructType,VectorWithOffsetType>
 	WaveFunctionTransfSu2Type;
 	typedef typename WaveFunctionTransfBaseType::WftOptions WftOptionsType;
+	typedef WftInfinite<WaveFunctionTransfBaseType> WftInfiniteType;
 	typedef typename PsimagLite::Stack<BlockDiagonalMatrixType>::Type WftStackType;
+	typedef OutOfCoreStack<BlockDiagonalMatrixType> WftOutOfCoreStackType;
 
 	template<typename SomeParametersType>
 	WaveFunctionTransfFactory(SomeParametersType& params)
@@ -131,7 +135,10 @@ public:
 	      filenameOut_(params.filename),
 	      WFT_STRING(ProgramGlobals::WFT_STRING),
 	      dmrgWaveStruct_(),
+	      wsStack_(params.filename, "WftSystem", residentStackEntries(params), false),
+	      weStack_(params.filename, "WftEnviron", residentStackEntries(params), false),
 	      wftImpl_(0),
+	      wftInfinite_(0),
 	      rng_(3433117),
 	      noLoad_(false),
 	      save_(params.options.find("noSaveWft") == PsimagLite::String::npos)
@@ -157,14 +164,21 @@ public:
 			wftImpl_=new WaveFunctionTransfSu2Type(dmrgWaveStruct_, wftOptions_);
 		else
 			wftImpl_=new WaveFunctionTransfLocalType(dmrgWaveStruct_, wftOptions_);
+
+		bool infinite = (params.options.find("wftInfinite") != PsimagLite::String::npos);
+		if (infinite && !BasisType::useSu2Symmetry())
+			wftInfinite_ = new WftInfiniteType(dmrgWaveStruct_);
 	}
 
 	~WaveFunctionTransfFactory()
 	{
-		if (!isEnabled_) return;
-		IoType::Out ioOut(filenameOut_, IoType::ACC_RDW);
-		write(ioOut);
+		if (isEnabled_) {
+			IoType::Out ioOut(filenameOut_, IoType::ACC_RDW);
+			write(ioOut);
+		}
+
 		delete wftImpl_;
+		delete wftInfinite_;
 	}
 
 	void setStage(ProgramGlobals::DirectionEnum stage)
@@ -231,7 +245,7 @@ public:
 			assert(!b);
 #endif
 			createVector(dest,src,lrs,nk);
-		} else {
+		} else if (!predictInfinite(dest,src,lrs,nk)) {
 			createRandomVector(dest);
 		}
 	}
@@ -306,6 +320,7 @@ public:
 			} else {
 				weStack_.push(transform);
 				dmrgWaveStruct_.we=transform;
+				if (wftInfinite_) wftInfinite_->push();
 			}
 			break;
 		case ProgramGlobals::EXPAND_ENVIRON:
@@ -362,7 +377,7 @@ public:
 		files.push_back(utils::pathPrepend(WFT_STRING,rootName));
 	}
 
-	void write(PsimagLite::IoSelector::Out& ioMain)
+	void write(PsimagLite::IoSelector::Out& ioMain) const
 	{
 		if (!isEnabled_) return;
 		if (!save_) return;
@@ -370,26 +385,35 @@ public:
 		writePartial(ioMain);
 
 		PsimagLite::String label = "Wft";
-		ioMain.write(wsStack_, label + "/wsStack");
-		ioMain.write(weStack_, label + "/weStack");
+		SizeType format = STACKS_FORMAT;
+		ioMain.write(format, label + "/StacksFormat");
+		wsStack_.write(ioMain, label + "/wsStack");
+		weStack_.write(ioMain, label + "/weStack");
 	}
 
-	void write(PsimagLite::IoSelector::Out& ioMain) const
-	{
-		if (!isEnabled_) return;
-		if (!save_) return;
-
-		writePartial(ioMain);
+private:
 
-		PsimagLite::String label = "Wft";
-		WftStackType wsStack = wsStack_;
-		ioMain.write(wsStack, label + "/wsStack");
+	// 0 had the stacks as written by IoNg, copied on write
+	static const SizeType STACKS_FORMAT = 1;
 
-		WftStackType weStack = weStack_;
-		ioMain.write(weStack, label + "/weStack");
+	// same as the checkpoint stacks, see stacksInDisk
+	template<typename SomeParametersType>
+	static SizeType residentStackEntries(const SomeParametersType& params)
+	{
+		bool inDisk = (params.options.find("stacksInDisk") != PsimagLite::String::npos);
+		return (inDisk) ? 2 : 0;
 	}
 
-private:
+	bool predictInfinite(VectorWithOffsetType& dest,
+	                     const VectorWithOffsetType& src,
+	                     const LeftRightSuperType& lrs,
+	                     const VectorSizeType& nk) const
+	{
+		if (!isEnabled_ || !wftInfinite_) return false;
+		if (wftOptions_.dir != ProgramGlobals::INFINITE) return false;
+
+		return (*wftInfinite_)(dest,src,lrs,nk);
+	}
 
 	void writePartial(PsimagLite::IoSelector::Out& ioMain) const
 	{
@@ -413,9 +437,41 @@ private:
 		ioMain.read(isEnabled_, label + "/isEnabled");
 		wftOptions_.read(ioMain, label + "/WftOptions");
 		dmrgWaveStruct_.read(ioMain, label + "/DmrgWaveStruct");
-		ioMain.read(wsStack_, label + "/wsStack");
-		ioMain.read(weStack_, label + "/weStack");
+		SizeType format = 0;
+		try {
+			ioMain.read(format, label + "/StacksFormat");
+		} catch (...) {}
+
+		if (format > STACKS_FORMAT)
+			err("WFT::read(...): unknown format of the stacks\n");
+
+		if (format == 0) {
+			readLegacyStack(wsStack_, ioMain, label + "/wsStack");
+			readLegacyStack(weStack_, ioMain, label + "/weStack");
+		}
+
 		ioMain.close();
+		if (format == 0) return;
+
+		// entries are read when first needed
+		wsStack_.pushAllFromFile(filenameIn_, label + "/wsStack");
+		weStack_.pushAllFromFile(filenameIn_, label + "/weStack");
+	}
+
+	static void readLegacyStack(WftOutOfCoreStackType& dest,
+	                            PsimagLite::IoSelector::In& ioMain,
+	                            PsimagLite::String label)
+	{
+		WftStackType tmp;
+		ioMain.read(tmp, label);
+		typename PsimagLite::Vector<BlockDiagonalMatrixType>::Type v(tmp.size());
+		for (SizeType i = 0; i < v.size(); ++i) {
+			v[v.size() - 1 - i].swap(tmp.top());
+			tmp.pop();
+		}
+
+		for (SizeType i = 0; i < v.size(); ++i)
+			dest.push(v[i]);
 	}
 
 	void myRandomT(std::complex<RealType> &value) const
@@ -541,9 +597,10 @@ private:
 	PsimagLite::String filenameOut_;
 	const PsimagLite::String WFT_STRING;
 	DmrgWaveStructType dmrgWaveStruct_;
-	WftStackType wsStack_;
-	WftStackType weStack_;
+	WftOutOfCoreStackType wsStack_;
+	WftOutOfCoreStackType weStack_;
 	WaveFunctionTransfBaseType* wftImpl_;
+	WftInfiniteType* wftInfinite_;
 	PsimagLite::Random48<RealType> rng_;
 	bool noLoad_;
 	const bool save_;
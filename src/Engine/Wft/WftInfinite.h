@@ -0,0 +1,357 @@
+#ifndef WFTINFINITE_H
+#define WFTINFINITE_H
+#include "Matrix.h"
+#include "BLAS.h"
+#include "ProgramGlobals.h"
+#include "ProgressIndicator.h"
+#include "Parallelizer.h"
+
+namespace Dmrg {
+
+/*
+ Initial guess for the infinite algorithm, see I. P. McCulloch, arXiv:0804.2509.
+ Let $\psi_n = A_n\Lambda_n B_n$ be the ground state of step $n$, with
+ $A_n$ and $B_n$ given by the DMRG transformations of system and environ.
+ The guess for step $n+1$ is
+ $(\Lambda_n B_n)\,\Lambda_{n-1}^{-1}\,(A_n\Lambda_n)$, where
+ the site that $B_n$ carried on the environ is now the site added to the system
+ and vice versa. $\Lambda_{n-1}^{-1}$ is the pseudo-inverse of the previous step's
+ center matrix, computed per symmetry block.
+ The prediction is used only if its projection onto the target sectors
+ is not zero; otherwise a random vector is used as before.
+ */
+template<typename WaveFunctionTransfBaseType>
+class WftInfinite {
+
+	typedef typename WaveFunctionTransfBaseType::DmrgWaveStructType DmrgWaveStructType;
+	typedef typename WaveFunctionTransfBaseType::VectorWithOffsetType VectorWithOffsetType;
+	typedef typename WaveFunctionTransfBaseType::VectorSizeType VectorSizeType;
+	typedef typename WaveFunctionTransfBaseType::PackIndicesType PackIndicesType;
+	typedef typename DmrgWaveStructType::LeftRightSuperType LeftRightSuperType;
+	typedef typename DmrgWaveStructType::BasisWithOperatorsType BasisWithOperatorsType;
+	typedef typename BasisWithOperatorsType::SparseMatrixType SparseMatrixType;
+	typedef typename VectorWithOffsetType::VectorType VectorType;
+	typedef typename VectorType::value_type ComplexOrRealType;
+	typedef typename PsimagLite::Real<ComplexOrRealType>::Type RealType;
+	typedef typename PsimagLite::Vector<RealType>::Type VectorRealType;
+	typedef PsimagLite::Matrix<ComplexOrRealType> MatrixType;
+
+	class ParallelPredict {
+
+	public:
+
+		ParallelPredict(VectorWithOffsetType& dest,
+		                SizeType i0,
+		                const LeftRightSuperType& lrs,
+		                const MatrixType& m1,
+		                const MatrixType& rmat)
+		    : dest_(dest),
+		      i0_(i0),
+		      lrs_(lrs),
+		      m1_(m1),
+		      rmat_(rmat),
+		      pack_(lrs.left().permutationInverse().size())
+		{}
+
+		SizeType tasks() const { return dest_.effectiveSize(i0_); }
+
+		void doTask(SizeType x, SizeType)
+		{
+			SizeType offset = dest_.offset(i0_);
+			SizeType isn = 0;
+			SizeType jen = 0;
+			pack_.unpack(isn, jen, lrs_.super().permutation(x + offset));
+			SizeType row = lrs_.left().permutation(isn);
+			SizeType col = lrs_.right().permutation(jen);
+			SizeType n = m1_.cols();
+			ComplexOrRealType sum = 0.0;
+			for (SizeType b = 0; b < n; ++b)
+				sum += m1_(row, b)*rmat_(b, col);
+
+			dest_.fastAccess(i0_, x) = sum;
+		}
+
+	private:
+
+		VectorWithOffsetType& dest_;
+		SizeType i0_;
+		const LeftRightSuperType& lrs_;
+		const MatrixType& m1_;
+		const MatrixType& rmat_;
+		PackIndicesType pack_;
+	};
+
+public:
+
+	WftInfinite(const DmrgWaveStructType& dmrgWaveStruct)
+	    : dmrgWaveStruct_(dmrgWaveStruct),
+	      pending_(false),
+	      progress_("WftInfinite")
+	{}
+
+	// Transforms of one infinite step have been pushed
+	void push() { pending_ = true; }
+
+	// Returns true if psiDest holds a prediction, false if caller must randomize
+	bool operator()(VectorWithOffsetType& psiDest,
+	                const VectorWithOffsetType& psiSrc,
+	                const LeftRightSuperType& lrs,
+	                const VectorSizeType& nk)
+	{
+		if (!pending_) return false;
+		pending_ = false;
+
+		SizeType volumeOfNk = DmrgWaveStructType::volumeOf(nk);
+		if (!sizesAreConsistent(psiSrc, lrs, volumeOfNk)) {
+			lambdaInv_.clear();
+			return false;
+		}
+
+		MatrixType lmat;
+		MatrixType rmat;
+		MatrixType lambda;
+		splitOld(lmat, rmat, lambda, psiSrc, volumeOfNk);
+
+		bool canPredict = (lambdaInv_.rows() > 0 &&
+		                   lambdaInv_.rows() == lmat.cols() &&
+		                   lambdaInv_.cols() == rmat.rows());
+
+		if (canPredict)
+			predict(psiDest, lmat, rmat, lrs);
+
+		pseudoInverse(lambdaInv_, lambda);
+
+		if (!canPredict) return false;
+
+		// the start vector is normalized sector by sector, so each one
+		// needs a projection of its own
+		RealType norma = norm(psiDest);
+		bool emptySector = hasEmptySector(psiDest);
+		PsimagLite::OstringStream msg;
+		msg<<"Infinite prediction with norm "<<norma;
+		if (norma < 1e-5)
+			msg<<" is too small, ignoring it";
+		else if (emptySector)
+			msg<<" has an empty sector, ignoring it";
+		progress_.printline(msg, std::cout);
+
+		return (norma >= 1e-5 && !emptySector);
+	}
+
+private:
+
+	static bool hasEmptySector(const VectorWithOffsetType& v)
+	{
+		for (SizeType ii = 0; ii < v.sectors(); ++ii) {
+			SizeType i0 = v.sector(ii);
+			SizeType total = v.effectiveSize(i0);
+			RealType sum = 0;
+			for (SizeType x = 0; x < total; ++x) {
+				RealType tmp = PsimagLite::norm(v.fastAccess(i0, x));
+				sum += tmp*tmp;
+			}
+
+			if (sqrt(sum) < 1e-5) return true;
+		}
+
+		return false;
+	}
+
+	bool sizesAreConsistent(const VectorWithOffsetType& psiSrc,
+	                        const LeftRightSuperType& lrs,
+	                        SizeType volumeOfNk) const
+	{
+		const LeftRightSuperType& lrsOld = dmrgWaveStruct_.lrs;
+		SizeType nalphaOld = lrsOld.left().permutationInverse().size();
+		SizeType nbetaOld = lrsOld.right().permutationInverse().size();
+
+		if (volumeOfNk == 0 || psiSrc.size() == 0) return false;
+		if (lrsOld.super().permutationInverse().size() != psiSrc.size()) return false;
+		if (nalphaOld != dmrgWaveStruct_.ws.rows()) return false;
+		if (nbetaOld != dmrgWaveStruct_.we.rows()) return false;
+		if (nalphaOld % volumeOfNk != 0 || nbetaOld % volumeOfNk != 0) return false;
+
+		SizeType nalpha = lrs.left().permutationInverse().size();
+		SizeType nbeta = lrs.right().permutationInverse().size();
+		return (nalpha == dmrgWaveStruct_.ws.cols()*volumeOfNk &&
+		        nbeta == dmrgWaveStruct_.we.cols()*volumeOfNk);
+	}
+
+	// lmat(s'' + tau*ns'', e) = (Lambda B)(s''; tau, e)
+	// rmat(s, sigma + e''*d) = (A Lambda)(s, sigma; e'')
+	// lambda(s'', e'') = A^dagger psi B^dagger
+	void splitOld(MatrixType& lmat,
+	              MatrixType& rmat,
+	              MatrixType& lambda,
+	              const VectorWithOffsetType& psiSrc,
+	              SizeType volumeOfNk) const
+	{
+		const LeftRightSuperType& lrsOld = dmrgWaveStruct_.lrs;
+		SparseMatrixType ws;
+		dmrgWaveStruct_.ws.toSparse(ws);
+		SparseMatrixType we;
+		dmrgWaveStruct_.we.toSparse(we);
+
+		SizeType nalphaOld = lrsOld.left().permutationInverse().size();
+		SizeType nbetaOld = lrsOld.right().permutationInverse().size();
+		SizeType ms = nalphaOld/volumeOfNk;
+		SizeType me = nbetaOld/volumeOfNk;
+		SizeType nsPrime = ws.cols();
+		SizeType nePrime = we.cols();
+
+		lmat.resize(nsPrime*volumeOfNk, me);
+		lmat.setTo(0.0);
+		MatrixType t(nalphaOld, nePrime);
+		t.setTo(0.0);
+
+		PackIndicesType packSuper(nalphaOld);
+		PackIndicesType packRight(volumeOfNk);
+		for (SizeType ii = 0; ii < psiSrc.sectors(); ++ii) {
+			SizeType i0 = psiSrc.sector(ii);
+			SizeType offset = psiSrc.offset(i0);
+			SizeType total = psiSrc.effectiveSize(i0);
+			for (SizeType x = 0; x < total; ++x) {
+				const ComplexOrRealType& v = psiSrc.fastAccess(i0, x);
+				if (v == static_cast<RealType>(0.0)) continue;
+				SizeType alpha = 0;
+				SizeType beta = 0;
+				packSuper.unpack(alpha, beta, lrsOld.super().permutation(x + offset));
+
+				for (SizeType k = we.getRowPtr(beta); k < we.getRowPtr(beta + 1); ++k)
+					t(alpha, we.getCol(k)) += v*PsimagLite::conj(we.getValue(k));
+
+				SizeType tau = 0;
+				SizeType e = 0;
+				packRight.unpack(tau, e, lrsOld.right().permutation(beta));
+				for (SizeType k = ws.getRowPtr(alpha); k < ws.getRowPtr(alpha + 1); ++k) {
+					SizeType row = ws.getCol(k) + tau*nsPrime;
+					lmat(row, e) += PsimagLite::conj(ws.getValue(k))*v;
+				}
+			}
+		}
+
+		rmat.resize(ms, volumeOfNk*nePrime);
+		rmat.setTo(0.0);
+		lambda.resize(nsPrime, nePrime);
+		lambda.setTo(0.0);
+		PackIndicesType packLeft(ms);
+		for (SizeType alpha = 0; alpha < nalphaOld; ++alpha) {
+			SizeType s = 0;
+			SizeType sigma = 0;
+			packLeft.unpack(s, sigma, lrsOld.left().permutation(alpha));
+			for (SizeType ep = 0; ep < nePrime; ++ep)
+				rmat(s, sigma + ep*volumeOfNk) = t(alpha, ep);
+
+			for (SizeType k = ws.getRowPtr(alpha); k < ws.getRowPtr(alpha + 1); ++k) {
+				ComplexOrRealType w = PsimagLite::conj(ws.getValue(k));
+				SizeType sp = ws.getCol(k);
+				for (SizeType ep = 0; ep < nePrime; ++ep)
+					lambda(sp, ep) += w*t(alpha, ep);
+			}
+		}
+	}
+
+	void predict(VectorWithOffsetType& psiDest,
+	             const MatrixType& lmat,
+	             const MatrixType& rmat,
+	             const LeftRightSuperType& lrs) const
+	{
+		SizeType rows = lmat.rows();
+		SizeType inner = lmat.cols();
+		SizeType cols = lambdaInv_.cols();
+		MatrixType m1(rows, cols);
+		m1.setTo(0.0);
+		if (rows > 0 && inner > 0 && cols > 0)
+			psimag::BLAS::GEMM('N',
+			                   'N',
+			                   rows,
+			                   cols,
+			                   inner,
+			                   1.0,
+			                   &(lmat(0,0)),
+			                   rows,
+			                   &(lambdaInv_(0,0)),
+			                   inner,
+			                   0.0,
+			                   &(m1(0,0)),
+			                   rows);
+
+		typedef PsimagLite::Parallelizer<ParallelPredict> ParallelizerType;
+		for (SizeType ii = 0; ii < psiDest.sectors(); ++ii) {
+			SizeType i0 = psiDest.sector(ii);
+			ParallelizerType threaded(PsimagLite::Concurrency::codeSectionParams);
+			ParallelPredict helper(psiDest, i0, lrs, m1, rmat);
+			threaded.loopCreate(helper);
+		}
+	}
+
+	// Pseudo-inverse by symmetry blocks of the transforms; discards
+	// singular values below cutoff relative to the largest in each block
+	void pseudoInverse(MatrixType& inv, const MatrixType& lambda) const
+	{
+		const RealType cutoff = 1e-8;
+		const VectorSizeType& rowOffsets = dmrgWaveStruct_.ws.offsetsCols();
+		const VectorSizeType& colOffsets = dmrgWaveStruct_.we.offsetsCols();
+
+		inv.clear();
+		inv.resize(lambda.cols(), lambda.rows());
+		inv.setTo(0.0);
+
+		for (SizeType ib = 0; ib + 1 < rowOffsets.size(); ++ib) {
+			SizeType r0 = rowOffsets[ib];
+			SizeType r = rowOffsets[ib + 1] - r0;
+			if (r == 0) continue;
+
+			VectorSizeType cols;
+			for (SizeType jb = 0; jb + 1 < colOffsets.size(); ++jb) {
+				if (!nonZeroBlock(lambda, r0, r, colOffsets[jb], colOffsets[jb + 1]))
+					continue;
+				for (SizeType j = colOffsets[jb]; j < colOffsets[jb + 1]; ++j)
+					cols.push_back(j);
+			}
+
+			SizeType c = cols.size();
+			if (c == 0) continue;
+
+			MatrixType a(r, c);
+			for (SizeType j = 0; j < c; ++j)
+				for (SizeType i = 0; i < r; ++i)
+					a(i, j) = lambda(i + r0, cols[j]);
+
+			MatrixType vt;
+			VectorRealType s;
+			svd('A', a, s, vt);
+
+			SizeType n = std::min(std::min(r, c), static_cast<SizeType>(s.size()));
+			if (n == 0 || s[0] <= 0) continue;
+			for (SizeType k = 0; k < n; ++k) {
+				if (s[k] < cutoff*s[0]) break;
+				RealType sinv = 1.0/s[k];
+				for (SizeType i = 0; i < r; ++i)
+					for (SizeType j = 0; j < c; ++j)
+						inv(cols[j], i + r0) += PsimagLite::conj(vt(k, j))*sinv*
+						        PsimagLite::conj(a(i, k));
+			}
+		}
+	}
+
+	static bool nonZeroBlock(const MatrixType& m,
+	                         SizeType r0,
+	                         SizeType r,
+	                         SizeType c0,
+	                         SizeType c1)
+	{
+		for (SizeType j = c0; j < c1; ++j)
+			for (SizeType i = r0; i < r0 + r; ++i)
+				if (PsimagLite::norm(m(i, j)) > 0) return true;
+
+		return false;
+	}
+
+	const DmrgWaveStructType& dmrgWaveStruct_;
+	bool pending_;
+	MatrixType lambdaInv_;
+	PsimagLite::ProgressIndicator progress_;
+}; // class WftInfinite
+} // namespace Dmrg
+#endif // WFTINFINITE_H